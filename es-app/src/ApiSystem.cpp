@@ -105,10 +105,7 @@ std::string ApiSystem::checkUpdateVersion()
 	
 	std::shared_ptr<HttpReq> httpreq = std::make_shared<HttpReq>("https://github.com/fabricecaruso/EmulationStation/releases/download/continuous-master/version.info");
 
-	while (httpreq->status() == HttpReq::REQ_IN_PROGRESS)
-		std::this_thread::sleep_for(std::chrono::milliseconds(20));
-
-	if (httpreq->status() == HttpReq::REQ_SUCCESS)
+	if (httpreq->wait() == HttpReq::REQ_SUCCESS)
 	{
 		std::string serverVersion = httpreq->getContent();
 		serverVersion = Utils::String::replace(Utils::String::replace(serverVersion, "\r", ""), "\n", "");
@@ -203,12 +200,10 @@ std::shared_ptr<HttpReq> downloadFile(const std::string url, const std::string l
 
 	std::shared_ptr<HttpReq> httpreq = std::make_shared<HttpReq>(url);
 
-	while (httpreq->status() == HttpReq::REQ_IN_PROGRESS)
+	while (httpreq->wait(20) == HttpReq::REQ_IN_PROGRESS)
 	{
 		if (func != nullptr)
 			func(std::string("Downloading " + label + " >>> " + std::to_string(httpreq->getPercent()) + " %"));
-
-		std::this_thread::sleep_for(std::chrono::milliseconds(20));
 	}
 
 	if (httpreq->status() != HttpReq::REQ_SUCCESS)
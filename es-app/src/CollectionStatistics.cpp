@@ -0,0 +1,111 @@
+#include "CollectionStatistics.h"
+
+#include "FileData.h"
+
+void CollectionStatistics::add(FileData* game)
+{
+	if (mGames.find(game) != mGames.cend())
+		remove(game);
+
+	Values values;
+	values.rating = game->metadata.get("rating");
+	values.players = game->metadata.get("players");
+	values.releaseDate = game->metadata.get("releasedate");
+	values.developer = game->metadata.get("developer");
+	values.genre = game->metadata.get("genre");
+
+	addValue(mRatings, values.rating);
+	addValue(mPlayers, values.players);
+	addValue(mReleaseDates, values.releaseDate);
+	addDistinct(mDevelopers, values.developer);
+	addDistinct(mGenres, values.genre);
+
+	mGames[game] = values;
+}
+
+void CollectionStatistics::remove(FileData* game)
+{
+	auto it = mGames.find(game);
+	if (it == mGames.cend())
+		return;
+
+	const Values& values = it->second;
+
+	removeValue(mRatings, values.rating);
+	removeValue(mPlayers, values.players);
+	removeValue(mReleaseDates, values.releaseDate);
+	removeDistinct(mDevelopers, values.developer);
+	removeDistinct(mGenres, values.genre);
+
+	mGames.erase(it);
+}
+
+std::string CollectionStatistics::getMaxRating(const std::string& defaultValue) const
+{
+	if (mRatings.empty() || *mRatings.crbegin() < defaultValue)
+		return defaultValue;
+
+	return *mRatings.crbegin();
+}
+
+std::string CollectionStatistics::getMaxPlayers(const std::string& defaultValue) const
+{
+	if (mPlayers.empty() || *mPlayers.crbegin() < defaultValue)
+		return defaultValue;
+
+	return *mPlayers.crbegin();
+}
+
+std::string CollectionStatistics::getEarliestReleaseDate(const std::string& defaultValue) const
+{
+	if (mReleaseDates.empty() || defaultValue < *mReleaseDates.cbegin())
+		return defaultValue;
+
+	return *mReleaseDates.cbegin();
+}
+
+std::string CollectionStatistics::getDeveloper(const std::string& noneValue, const std::string& variousValue) const
+{
+	return getDistinct(mDevelopers, noneValue, variousValue);
+}
+
+std::string CollectionStatistics::getGenre(const std::string& noneValue, const std::string& variousValue) const
+{
+	return getDistinct(mGenres, noneValue, variousValue);
+}
+
+void CollectionStatistics::addValue(std::multiset<std::string>& set, const std::string& value)
+{
+	if (!value.empty())
+		set.insert(value);
+}
+
+void CollectionStatistics::removeValue(std::multiset<std::string>& set, const std::string& value)
+{
+	auto it = set.find(value);
+	if (it != set.end())
+		set.erase(it);
+}
+
+void CollectionStatistics::addDistinct(std::map<std::string, int>& map, const std::string& value)
+{
+	map[value]++;
+}
+
+void CollectionStatistics::removeDistinct(std::map<std::string, int>& map, const std::string& value)
+{
+	auto it = map.find(value);
+	if (it != map.end() && --it->second <= 0)
+		map.erase(it);
+}
+
+std::string CollectionStatistics::getDistinct(const std::map<std::string, int>& map, const std::string& noneValue, const std::string& variousValue)
+{
+	if (map.empty())
+		return noneValue;
+
+	if (map.size() > 1)
+		return variousValue;
+
+	return map.cbegin()->first;
+}
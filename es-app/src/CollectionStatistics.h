@@ -0,0 +1,59 @@
+#pragma once
+#ifndef ES_APP_COLLECTION_STATISTICS_H
+#define ES_APP_COLLECTION_STATISTICS_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+class FileData;
+
+// Aggregated metadata of the games of a collection, updated as games are added & removed instead of scanning them all.
+// The values of each game are remembered when it's added, so removing it doesn't depend on its current metadata.
+class CollectionStatistics
+{
+public:
+	void add(FileData* game);
+	void remove(FileData* game);
+
+	inline int getCount() const { return (int)mGames.size(); }
+
+	// Highest non empty value, or defaultValue when there's none
+	std::string getMaxRating(const std::string& defaultValue) const;
+	std::string getMaxPlayers(const std::string& defaultValue) const;
+	// Lowest non empty value, or defaultValue when there's none
+	std::string getEarliestReleaseDate(const std::string& defaultValue) const;
+
+	// The value shared by all the games, variousValue if they differ, or noneValue when there's no game
+	std::string getDeveloper(const std::string& noneValue, const std::string& variousValue) const;
+	std::string getGenre(const std::string& noneValue, const std::string& variousValue) const;
+
+private:
+	struct Values
+	{
+		std::string rating;
+		std::string players;
+		std::string releaseDate;
+		std::string developer;
+		std::string genre;
+	};
+
+	static void addValue(std::multiset<std::string>& set, const std::string& value);
+	static void removeValue(std::multiset<std::string>& set, const std::string& value);
+	static void addDistinct(std::map<std::string, int>& map, const std::string& value);
+	static void removeDistinct(std::map<std::string, int>& map, const std::string& value);
+	static std::string getDistinct(const std::map<std::string, int>& map, const std::string& noneValue, const std::string& variousValue);
+
+	std::unordered_map<FileData*, Values> mGames;
+
+	std::multiset<std::string> mRatings;
+	std::multiset<std::string> mPlayers;
+	std::multiset<std::string> mReleaseDates;
+
+	// value -> number of games
+	std::map<std::string, int> mDevelopers;
+	std::map<std::string, int> mGenres;
+};
+
+#endif // ES_APP_COLLECTION_STATISTICS_H
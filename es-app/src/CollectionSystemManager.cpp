@@ -5,8 +5,11 @@
 #include "utils/StringUtil.h"
 #include "views/gamelist/IGameListView.h"
 #include "views/ViewController.h"
+#include "CollectionStatistics.h"
 #include "FileData.h"
+#include "FileDataArena.h"
 #include "FileFilterIndex.h"
+#include "GameCatalogue.h"
 #include "Log.h"
 #include "Settings.h"
 #include "SystemData.h"
@@ -178,11 +181,8 @@ void CollectionSystemManager::updateSystemsList()
 	// remove all Collection Systems
 	removeCollectionsFromDisplayedSystems();
 
-	std::unordered_map<std::string, FileData*> map;
-	getAllGamesCollection()->getRootFolder()->createChildrenByFilenameMap(map);
-
 	// add custom enabled ones
-	addEnabledCollectionsToDisplayedSystems(&mCustomCollectionSystemsData, &map);
+	addEnabledCollectionsToDisplayedSystems(&mCustomCollectionSystemsData);
 
 	if (Settings::getInstance()->getBool("SortAllSystems"))
 	{
@@ -213,7 +213,7 @@ void CollectionSystemManager::updateSystemsList()
 	}
 
 	// add auto enabled ones
-	addEnabledCollectionsToDisplayedSystems(&mAutoCollectionSystemsData, &map);
+	addEnabledCollectionsToDisplayedSystems(&mAutoCollectionSystemsData);
 	/*
 	// create views for collections, before reload
 	for(auto sysIt = SystemData::sSystemVector.cbegin(); sysIt != SystemData::sSystemVector.cend(); sysIt++)
@@ -238,29 +238,28 @@ void CollectionSystemManager::refreshCollectionSystems(FileData* file)
 	if (!file->getSystem()->isGameSystem() || file->getType() != GAME)
 		return;
 
-	std::map<std::string, CollectionSystemData> allCollections;
-	allCollections.insert(mAutoCollectionSystemsData.cbegin(), mAutoCollectionSystemsData.cend());
-	allCollections.insert(mCustomCollectionSystemsData.cbegin(), mCustomCollectionSystemsData.cend());
+	// the metadata of the file changed : the collections below are decided on its catalogue row
+	GameCatalogue::getInstance()->update(file);
+	file->getSystem()->updateDisplayedGameCount();
 
-	for(auto sysDataIt = allCollections.cbegin(); sysDataIt != allCollections.cend(); sysDataIt++)
-	{
-		updateCollectionSystem(file, sysDataIt->second);
-	}
+	for (auto& sysData : mAutoCollectionSystemsData)
+		updateCollectionSystem(file, sysData.second);
+
+	for (auto& sysData : mCustomCollectionSystemsData)
+		updateCollectionSystem(file, sysData.second);
 }
 
-void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionSystemData sysData)
+// Only the entry of the file is added, removed or moved : the collection stays sorted without sorting it all again
+void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionSystemData& sysData)
 {
 	if (sysData.isPopulated)
 	{
-		// collection files use the full path as key, to avoid clashes
-		std::string key = file->getFullPath();
-
 		SystemData* curSys = sysData.system;	
-		FileData* collectionEntry = curSys->getRootFolder()->FindByPath(key);
-
 		FolderData* rootFolder = curSys->getRootFolder();
-		
-		std::string name = curSys->getName();
+		FileData* collectionEntry = rootFolder->FindBySourceFile(file->getSourceFileData());
+
+		FolderData::SortType sortType = getSortTypeFromString(sysData.decl.defaultSort);
+		CollectionSystemType type = sysData.decl.type;
 
 		if (collectionEntry != nullptr) 
 		{
@@ -268,8 +267,9 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 			// remove from index, so we can re-index metadata after refreshing
 			curSys->removeFromIndex(collectionEntry);
 			collectionEntry->refreshMetadata();
+			rootFolder->updateCollectionStatistics(collectionEntry);
 			// found and we are removing
-			if (name == "favorites" && file->metadata.get("favorite") == "false") {
+			if (type == AUTO_FAVORITES && !isInAutoCollection(file, type)) {
 				// need to check if still marked as favorite, if not remove
 				ViewController::get()->getGameListView(curSys).get()->remove(collectionEntry, false);
 				
@@ -280,16 +280,17 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 			{
 				// re-index with new metadata
 				curSys->addToIndex(collectionEntry);
+				rootFolder->resortChild(collectionEntry, sortType);
 				ViewController::get()->onFileChanged(collectionEntry, FILE_METADATA_CHANGED);
 			}
 		}
 		else
 		{
 			// we didn't find it here - we need to check if we should add it
-			if (name == "recent" && file->metadata.get("playcount") > "0" && includeFileInAutoCollections(file) ||
-				name == "favorites" && file->metadata.get("favorite") == "true") {
+			if ((type == AUTO_LAST_PLAYED || type == AUTO_FAVORITES) && isInAutoCollection(file, type)) {
 				CollectionFileData* newGame = new CollectionFileData(file, curSys);
 				rootFolder->addChild(newGame);
+				rootFolder->resortChild(newGame, sortType);
 				curSys->addToIndex(newGame);
 				
 				ViewController::get()->onFileChanged(file, FILE_METADATA_CHANGED);
@@ -299,8 +300,7 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 
 		curSys->updateDisplayedGameCount();
 
-		rootFolder->sort(getSortTypeFromString(mCollectionSystemDeclsIndex[name].defaultSort));
-		if (name == "recent")
+		if (type == AUTO_LAST_PLAYED)
 		{
 			trimCollectionCount(rootFolder, LAST_PLAYED_MAX);
 			ViewController::get()->onFileChanged(rootFolder, FILE_METADATA_CHANGED);
@@ -310,6 +310,7 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 	}
 }
 
+// removes the last entries over limit : after resortChild, at most one for 'last played', taken from the back of the children
 void CollectionSystemManager::trimCollectionCount(FolderData* rootFolder, int limit)
 {
 	SystemData* curSys = rootFolder->getSystem();
@@ -329,22 +330,19 @@ void CollectionSystemManager::trimCollectionCount(FolderData* rootFolder, int li
 // deletes all collection files from collection systems related to the source file
 void CollectionSystemManager::deleteCollectionFiles(FileData* file)
 {
-	// collection files use the full path as key, to avoid clashes
-	std::string key = file->getFullPath();
 	// find games in collection systems
-	std::map<std::string, CollectionSystemData> allCollections;
-	allCollections.insert(mAutoCollectionSystemsData.cbegin(), mAutoCollectionSystemsData.cend());
-	allCollections.insert(mCustomCollectionSystemsData.cbegin(), mCustomCollectionSystemsData.cend());
-
-	for(auto sysDataIt = allCollections.begin(); sysDataIt != allCollections.end(); sysDataIt++)
+	for (auto collections : { &mAutoCollectionSystemsData, &mCustomCollectionSystemsData })
 	{
-		if (sysDataIt->second.isPopulated)
+		for (auto& sysData : *collections)
 		{
-			FileData* collectionEntry = (sysDataIt->second.system)->getRootFolder()->FindByPath(key);
+			if (!sysData.second.isPopulated)
+				continue;
+
+			FileData* collectionEntry = sysData.second.system->getRootFolder()->FindBySourceFile(file->getSourceFileData());
 			if (collectionEntry != nullptr)
 			{
-				sysDataIt->second.needsSave = true;				
-				SystemData* systemViewToUpdate = getSystemToView(sysDataIt->second.system);
+				sysData.second.needsSave = true;
+				SystemData* systemViewToUpdate = getSystemToView(sysData.second.system);
 				ViewController::get()->getGameListView(systemViewToUpdate).get()->remove(collectionEntry, false);
 			}
 		}
@@ -492,10 +490,9 @@ bool CollectionSystemManager::toggleGameInCollection(FileData* file)
 			if (!mEditingCollectionSystemData->isPopulated)
 				populateCustomCollection(mEditingCollectionSystemData);
 
-			std::string key = file->getFullPath();
 			FolderData* rootFolder = sysData->getRootFolder();
 
-			FileData* collectionEntry = rootFolder->FindByPath(key);
+			FileData* collectionEntry = rootFolder->FindBySourceFile(file->getSourceFileData());
 			
 			std::string name = sysData->getName();
 
@@ -519,7 +516,7 @@ bool CollectionSystemManager::toggleGameInCollection(FileData* file)
 				rootFolder->addChild(newGame);
 				sysData->addToIndex(newGame);
 				ViewController::get()->getGameListView(systemViewToUpdate)->onFileChanged(newGame, FILE_METADATA_CHANGED);
-				rootFolder->sort(getSortTypeFromString(mEditingCollectionSystemData->decl.defaultSort));
+				rootFolder->resortChild(newGame, getSortTypeFromString(mEditingCollectionSystemData->decl.defaultSort));
 				ViewController::get()->onFileChanged(systemViewToUpdate->getRootFolder(), FILE_SORTED);
 				// add to bundle index as well, if needed
 				if(systemViewToUpdate != sysData)
@@ -578,7 +575,7 @@ SystemData* CollectionSystemManager::getSystemToView(SystemData* sys)
 	FolderData* bundleRootFolder = mCustomCollectionsBundle->getRootFolder();
 
 	// is the rootFolder bundled in the "My Collections" system?
-	bool sysFoundInBundle = bundleRootFolder->FindByPath(rootFolder->getKey()) != nullptr;
+	bool sysFoundInBundle = rootFolder->getParent() == bundleRootFolder;
 	if (sysFoundInBundle && sys->isCollection())
 	{
 		systemToView = mCustomCollectionsBundle;
@@ -616,45 +613,29 @@ void CollectionSystemManager::updateCollectionFolderMetadata(SystemData* sys)
 	std::string thumbnail = "";
 	std::string image = "";
 
-	auto games = rootFolder->getChildren();
+	// the aggregates are maintained by the folder as games are added & removed
+	const CollectionStatistics* statistics = rootFolder->getCollectionStatistics();
+	auto& games = rootFolder->getChildren();
 
-	if(games.size() > 0)
+	if(statistics != nullptr && statistics->getCount() > 0)
 	{
+		rating = statistics->getMaxRating(rating);
+		players = statistics->getMaxPlayers(players);
+		releasedate = statistics->getEarliestReleaseDate(releasedate);
+		developer = statistics->getDeveloper(developer, _("Various"));
+		genre = statistics->getGenre(genre, _("Various"));
+
+		// only the first titles are listed
 		std::string games_list = "";
-		int games_counter = 0;
-		for(auto iter = games.cbegin(); iter != games.cend(); ++iter)
-		{
-			games_counter++;
-			FileData* file = *iter;
-
-			std::string new_rating = file->metadata.get("rating");
-			std::string new_releasedate = file->metadata.get("releasedate");
-			std::string new_developer = file->metadata.get("developer");
-			std::string new_genre = file->metadata.get("genre");
-			std::string new_players = file->metadata.get("players");
-
-			rating = (new_rating > rating ? (new_rating != "" ? new_rating : rating) : rating);
-			players = (new_players > players ? (new_players != "" ? new_players : players) : players);
-			releasedate = (new_releasedate < releasedate ? (new_releasedate != "" ? new_releasedate : releasedate) : releasedate);
-			developer = (developer == _("None") ? new_developer : (new_developer != developer ? _("Various") : new_developer));
-			genre = (genre == _("None") ? new_genre : (new_genre != genre ? _("Various") : new_genre));
-
-			switch(games_counter)
-			{
-				case 2:
-				case 3:
-					games_list += ", ";
-				case 1:
-					games_list += "'" + file->getName() + "'";
-					break;
-				case 4:
-					games_list += " " + _("among other titles.");
-			}
-		}
+		for (int i = 0; i < (int)games.size() && i < 3; i++)
+			games_list += (i > 0 ? ", " : "") + std::string("'") + games[i]->getName() + "'";
+
+		if (games.size() > 3)
+			games_list += " " + _("among other titles.");
 
-		desc = _("This collection contains") + " " + std::to_string(games_counter) + " " + _("games, including") + " " + games_list;
+		desc = _("This collection contains") + " " + std::to_string(statistics->getCount()) + " " + _("games, including") + " " + games_list;
 
-		FileData* randomGame = sys->getRandomGame();
+		FileData* randomGame = games.empty() ? nullptr : games[std::rand() % games.size()];
 		if (randomGame != nullptr)
 		{
 			video = randomGame->getVideoPath();
@@ -684,14 +665,32 @@ void CollectionSystemManager::initCustomCollectionSystems()
 	}
 }
 
-SystemData* CollectionSystemManager::getAllGamesCollection()
+CollectionSystemData* CollectionSystemManager::getCollectionSystemData(SystemData* sys)
 {
-	CollectionSystemData* allSysData = &mAutoCollectionSystemsData["all"];
-	if (!allSysData->isPopulated)
-	{
-		populateAutoCollection(allSysData);
-	}
-	return allSysData->system;
+	for (auto collections : { &mAutoCollectionSystemsData, &mCustomCollectionSystemsData })
+		for (auto& sysData : *collections)
+			if (sysData.second.system == sys)
+				return &sysData.second;
+
+	return nullptr;
+}
+
+void CollectionSystemManager::populateCollection(SystemData* sys)
+{
+	CollectionSystemData* sysData = getCollectionSystemData(sys);
+	if (sysData == nullptr || sysData->isPopulated)
+		return;
+
+	if (sysData->decl.isCustom)
+		populateCustomCollection(sysData);
+	else
+		populateAutoCollection(sysData);
+}
+
+bool CollectionSystemManager::isPopulated(SystemData* sys)
+{
+	CollectionSystemData* sysData = getCollectionSystemData(sys);
+	return sysData == nullptr || sysData->isPopulated;
 }
 
 SystemData* CollectionSystemManager::addNewCustomCollection(std::string name)
@@ -736,48 +735,65 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 	SystemData* newSys = sysData->system;
 	CollectionSystemDecl sysDecl = sysData->decl;
 	FolderData* rootFolder = newSys->getRootFolder();
+
+	FileDataArena::Scope arenaScope(newSys->getArena());
+
+	// the played games are ranked by date (packed in a long long by the catalogue) first, so that only the LAST_PLAYED_MAX most recent ones get an entry
+	std::multimap<long long, FileData*> lastPlayed;
+	GameCatalogue* catalogue = GameCatalogue::getInstance();
+
+	auto addGame = [newSys, rootFolder](FileData* game)
+	{
+		CollectionFileData* newGame = new CollectionFileData(game, newSys);
+		rootFolder->addChild(newGame);
+		newSys->addToIndex(newGame);
+	};
 	
 	for(auto sysIt = SystemData::sSystemVector.cbegin(); sysIt != SystemData::sSystemVector.cend(); sysIt++)
 	{
 		// we won't iterate all collections
 		if ((*sysIt)->isGameSystem() && !(*sysIt)->isCollection()) 
 		{
-			std::vector<FileData*> files = (*sysIt)->getRootFolder()->getFilesRecursive(GAME);
-			for(auto gameIt = files.cbegin(); gameIt != files.cend(); gameIt++)
+			(*sysIt)->getRootFolder()->visitFiles(GAME, [&](FileData* game)
 			{
-				bool include = includeFileInAutoCollections((*gameIt));
-				switch(sysDecl.type) {
-					case AUTO_LAST_PLAYED:
-						include = include && (*gameIt)->metadata.get("playcount") > "0";
-						break;
-					case AUTO_FAVORITES:
-						// we may still want to add files we don't want in auto collections in "favorites"
-						include = (*gameIt)->metadata.get("favorite") == "true";
-						break;
-				}
+				if (!isInAutoCollection(game, sysDecl.type))
+					return true;
 
-				if (include) {
-					CollectionFileData* newGame = new CollectionFileData(*gameIt, newSys);
-					rootFolder->addChild(newGame);
-					newSys->addToIndex(newGame);
+				if (sysDecl.type == AUTO_LAST_PLAYED)
+				{
+					int id = game->getCatalogueId();
+					long long time = (id >= 0 ? catalogue->getLastPlayed(id) : game->metadata.getDate("lastplayed"));
+
+					lastPlayed.insert(std::make_pair(time, game));
+					if (lastPlayed.size() > LAST_PLAYED_MAX)
+						lastPlayed.erase(lastPlayed.begin());
 				}
-			}
+				else
+					addGame(game);
+
+				return true;
+			});
 		}
 	}
+
+	for (auto game : lastPlayed)
+		addGame(game.second);
+
 	rootFolder->sort(getSortTypeFromString(sysDecl.defaultSort));
-	if (sysDecl.type == AUTO_LAST_PLAYED)
-		trimCollectionCount(rootFolder, LAST_PLAYED_MAX);
 	sysData->isPopulated = true;
 }
 
 // populates a Custom Collection System
-void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sysData, std::unordered_map<std::string, FileData*>* pMap)
+void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sysData)
 {
 	SystemData* newSys = sysData->system;
 	sysData->isPopulated = true;
 	CollectionSystemDecl sysDecl = sysData->decl;
 	std::string path = getCustomCollectionConfigPath(newSys->getName());
 
+	// the folder metadata of custom collections sums up their games, see updateCollectionFolderMetadata
+	newSys->getRootFolder()->enableCollectionStatistics();
+
 	if(!Utils::FileSystem::exists(path))
 	{
 		LOG(LogInfo) << "Couldn't find custom collection config file at " << path;
@@ -790,25 +806,22 @@ void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sys
 	// get Configuration for this Custom System
 	std::ifstream input(path);
 
-	FolderData* folder = getAllGamesCollection()->getRootFolder();
-
-	std::unordered_map<std::string, FileData*> map;
-
-	if (pMap == nullptr)
-	{		
-		folder->createChildrenByFilenameMap(map);
-		pMap = &map;
-	}
+	FileDataArena::Scope arenaScope(newSys->getArena());
 
 	// iterate list of files in config file
 	for(std::string gameKey; getline(input, gameKey); )
 	{
 		gameKey = Utils::FileSystem::resolveRelativePath(gameKey, "portnawak", true);
 
-		std::unordered_map<std::string, FileData*>::const_iterator it = pMap->find(gameKey);
-		if (it != pMap->cend())
+		// the games are looked up in the path index, like "all games" would hold them
+		FileData* game = nullptr;
+		for (auto file : FolderData::FindSystemFilesByPath(gameKey))
+			if (file->getType() == GAME && isInAutoCollection(file, AUTO_ALL_GAMES))
+				game = file;
+
+		if (game != nullptr)
 		{
-			CollectionFileData* newGame = new CollectionFileData(it->second, newSys);
+			CollectionFileData* newGame = new CollectionFileData(game, newSys);
 			rootFolder->addChild(newGame);
 			newSys->addToIndex(newGame);
 		}
@@ -852,34 +865,26 @@ void CollectionSystemManager::removeCollectionsFromDisplayedSystems()
 	ViewController::get()->removeGameListView(mCustomCollectionsBundle);
 }
 
-void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<std::string, CollectionSystemData>* colSystemData, std::unordered_map<std::string, FileData*>* pMap)
+void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<std::string, CollectionSystemData>* colSystemData)
 {
 	// add auto enabled ones
 	for(std::map<std::string, CollectionSystemData>::iterator it = colSystemData->begin() ; it != colSystemData->end() ; it++ )
 	{
 		if(it->second.isEnabled)
 		{
-			// check if populated, otherwise populate
-			if (!it->second.isPopulated)
-			{
-				if(it->second.decl.isCustom)
-				{
-					populateCustomCollection(&(it->second), pMap);
-				}
-				else
-				{
-					populateAutoCollection(&(it->second));
-				}
-			}
 			// check if it has its own view
 			if(!it->second.decl.isCustom || themeFolderExists(it->first) || !Settings::getInstance()->getBool("UseCustomCollectionsSystem"))
 			{
 				// exists theme folder, or we chose not to bundle it under the custom-collections system
-				// so we need to create a view
+				// so we need to create a view. It will be populated when first shown, see populateCollection
 				SystemData::sSystemVector.push_back(it->second.system);
 			}
 			else
 			{
+				// the bundle needs the games now, to import their index
+				if (!it->second.isPopulated)
+					populateCustomCollection(&(it->second));
+
 				FileData* newSysRootFolder = it->second.system->getRootFolder();
 				mCustomCollectionsBundle->getRootFolder()->addChild(newSysRootFolder);
 				mCustomCollectionsBundle->getIndex(true)->importIndex(it->second.system->getIndex(true));
@@ -1067,6 +1072,25 @@ bool CollectionSystemManager::themeFolderExists(std::string folder)
 	return std::find(themeSys.cbegin(), themeSys.cend(), folder) != themeSys.cend();
 }
 
+bool CollectionSystemManager::isInAutoCollection(FileData* file, CollectionSystemType type)
+{
+	GameCatalogue* catalogue = GameCatalogue::getInstance();
+	int id = file->getCatalogueId();
+
+	switch (type)
+	{
+		case AUTO_ALL_GAMES:
+			return includeFileInAutoCollections(file);
+		case AUTO_LAST_PLAYED:
+			return includeFileInAutoCollections(file) && (id >= 0 ? catalogue->getPlayCount(id) : file->metadata.getInt("playcount")) > 0;
+		case AUTO_FAVORITES:
+			// we may still want to add files we don't want in auto collections in "favorites"
+			return id >= 0 ? catalogue->hasFlags(id, GameCatalogue::FAVORITE) : file->metadata.get("favorite") == "true";
+		default:
+			return false;
+	}
+}
+
 bool CollectionSystemManager::includeFileInAutoCollections(FileData* file)
 {
 	// we exclude non-game files from collections (i.e. "kodi", entries from non-game systems)
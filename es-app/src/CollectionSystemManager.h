@@ -56,7 +56,7 @@ public:
 	void updateSystemsList();
 
 	void refreshCollectionSystems(FileData* file);
-	void updateCollectionSystem(FileData* file, CollectionSystemData sysData);
+	void updateCollectionSystem(FileData* file, CollectionSystemData& sysData);
 	void deleteCollectionFiles(FileData* file);
 
 	inline std::map<std::string, CollectionSystemData> getAutoCollectionSystems() { return mAutoCollectionSystemsData; };
@@ -76,6 +76,11 @@ public:
 	bool toggleGameInCollection(FileData* file);
 
 	SystemData* getSystemToView(SystemData* sys);
+
+	// Enabled collections are only populated the first time they are shown, or their game count is needed
+	void populateCollection(SystemData* sys);
+	bool isPopulated(SystemData* sys);
+
 	void updateCollectionFolderMetadata(SystemData* sys);
 
 private:
@@ -91,13 +96,13 @@ private:
 
 	void initAutoCollectionSystems();
 	void initCustomCollectionSystems();
-	SystemData* getAllGamesCollection();
 	SystemData* createNewCollectionEntry(std::string name, CollectionSystemDecl sysDecl, bool index = true);
 	void populateAutoCollection(CollectionSystemData* sysData);
-	void populateCustomCollection(CollectionSystemData* sysData, std::unordered_map<std::string, FileData*>* pMap = nullptr);
+	void populateCustomCollection(CollectionSystemData* sysData);
+	CollectionSystemData* getCollectionSystemData(SystemData* sys);
 
 	void removeCollectionsFromDisplayedSystems();
-	void addEnabledCollectionsToDisplayedSystems(std::map<std::string, CollectionSystemData>* colSystemData, std::unordered_map<std::string, FileData*>* pMap);
+	void addEnabledCollectionsToDisplayedSystems(std::map<std::string, CollectionSystemData>* colSystemData);
 
 	std::vector<std::string> getSystemsFromConfig();
 	std::vector<std::string> getSystemsFromTheme();
@@ -110,6 +115,8 @@ private:
 	bool themeFolderExists(std::string folder);
 
 	bool includeFileInAutoCollections(FileData* file);
+	// Whether the metadata of file puts it in an auto collection of this type
+	bool isInAutoCollection(FileData* file, CollectionSystemType type);
 
 	SystemData* mCustomCollectionsBundle;
 };
@@ -4,25 +4,54 @@
 #include "utils/StringUtil.h"
 #include "utils/TimeUtil.h"
 #include "AudioManager.h"
+#include "CollectionStatistics.h"
 #include "CollectionSystemManager.h"
+#include "FileDataArena.h"
 #include "FileFilterIndex.h"
 #include "FileSorts.h"
+#include "GameCatalogue.h"
 #include "Log.h"
 #include "MameNames.h"
+#include "MediaIndex.h"
 #include "platform.h"
 #include "Scripting.h"
 #include "SystemData.h"
 #include "VolumeControl.h"
 #include "Window.h"
 #include "views/UIModeController.h"
+#include <algorithm>
 #include <assert.h>
+#include <mutex>
+#include <unordered_set>
+
+// Directories are never removed from the pool, so that the FileData can keep pointers to them
+static std::unordered_set<std::string> sDirectoryPool;
+static std::mutex sDirectoryPoolLock;
+
+static const std::string* internDirectory(const std::string& directory)
+{
+	std::unique_lock<std::mutex> lock(sDirectoryPoolLock);
+	return &(*sDirectoryPool.insert(directory).first);
+}
 
 FileData::FileData(FileType type, const std::string& path, SystemData* system)
-	: mType(type), mSystem(system), mParent(NULL), metadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
+	: mType(type), mSystem(system), mParent(NULL), mDirectory(NULL), mCatalogueId(-1), metadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
 {
-	mPath = Utils::FileSystem::createRelativePath(path, getSystemEnvData()->mStartPath, false);
+	const std::string& startPath = getSystemEnvData()->mStartPath;
+
+	std::string relativePath = Utils::FileSystem::createRelativePath(path, startPath, false);
+	std::string fullPath = relativePath.empty() ? startPath : Utils::FileSystem::resolveRelativePath(relativePath, startPath, true);
+
+	size_t separator = fullPath.find_last_of('/');
+	if (separator == std::string::npos)
+		mFileName = fullPath;
+	else
+	{
+		mDirectory = internDirectory(fullPath.substr(0, separator));
+		mFileName = fullPath.substr(separator + 1);
+	}
 	
-//	TRACE("FileData : " << mPath);
+//	TRACE("FileData : " << fullPath);
 
 	// metadata needs at least a name field (since that's what getName() will return)
 	if (metadata.get("name").empty())
@@ -31,12 +60,60 @@ FileData::FileData(FileType type, const std::string& path, SystemData* system)
 	metadata.resetChangedFlag();
 }
 
+// Each node is preceded by the arena it comes from (NULL for the heap) and its size, so that delete knows what to do with it
+#define NODE_HEADER_SIZE	16
+
+struct NodeHeader
+{
+	FileDataArena* arena;
+	size_t size;
+};
+
+static_assert(sizeof(NodeHeader) <= NODE_HEADER_SIZE, "NODE_HEADER_SIZE is too small");
+
+void* FileData::operator new(size_t size)
+{
+	FileDataArena* arena = FileDataArena::getCurrent();
+
+	char* memory = (char*)(arena != nullptr ? arena->allocate(size + NODE_HEADER_SIZE) : ::operator new(size + NODE_HEADER_SIZE));
+
+	NodeHeader* header = (NodeHeader*)memory;
+	header->arena = arena;
+	header->size = size + NODE_HEADER_SIZE;
+
+	return memory + NODE_HEADER_SIZE;
+}
+
+void FileData::operator delete(void* ptr)
+{
+	if (ptr == nullptr)
+		return;
+
+	char* memory = (char*)ptr - NODE_HEADER_SIZE;
+	NodeHeader* header = (NodeHeader*)memory;
+
+	if (header->arena != nullptr)
+		header->arena->release(memory, header->size);
+	else
+		::operator delete(memory);
+}
+
 const std::string FileData::getPath() const
 { 	
-	if (mPath.empty())
-		return getSystemEnvData()->mStartPath;
+	if (mDirectory == NULL)
+		return mFileName;
+
+	return *mDirectory + "/" + mFileName;
+}
+
+std::string FileData::getStem() const
+{
+	return Utils::FileSystem::getStem(mFileName);
+}
 
-	return Utils::FileSystem::resolveRelativePath(mPath, getSystemEnvData()->mStartPath, true);	
+std::string FileData::getExtension() const
+{
+	return Utils::FileSystem::getExtension(mFileName);
 }
 
 inline SystemEnvironmentData* FileData::getSystemEnvData() const
@@ -56,11 +133,14 @@ FileData::~FileData()
 
 	if(mType == GAME)
 		mSystem->removeFromIndex(this);	
+
+	if (mCatalogueId >= 0)
+		GameCatalogue::getInstance()->remove(this);
 }
 
 std::string FileData::getDisplayName() const
 {
-	std::string stem = Utils::FileSystem::getStem(getPath());
+	std::string stem = getStem();
 	if(mSystem && mSystem->hasPlatformId(PlatformIds::ARCADE) || mSystem->hasPlatformId(PlatformIds::NEOGEO))
 		stem = MameNames::getInstance()->getRealName(stem);
 
@@ -72,6 +152,25 @@ std::string FileData::getCleanName() const
 	return Utils::String::removeParenthesis(this->getDisplayName());
 }
 
+static const char* imageExtensions[2] = { ".png", ".jpg" };
+static const char* videoExtensions[1] = { ".mp4" };
+
+// Local art lookups are answered by the media index instead of probing the disk for each extension
+std::string FileData::findLocalMedia(const std::string& suffix, const char** extensions, int count) const
+{
+	return MediaIndex::getInstance()->findMedia(getSystemEnvData()->mStartPath + "/images", getDisplayName(), suffix, extensions, count);
+}
+
+bool FileData::hasLocalVideo(const std::string& mediaDirectory, const std::string& displayName)
+{
+	return !MediaIndex::getInstance()->findMedia(mediaDirectory, displayName, "-video", videoExtensions, 1).empty();
+}
+
+bool FileData::hasLocalImage(const std::string& mediaDirectory, const std::string& displayName)
+{
+	return !MediaIndex::getInstance()->findMedia(mediaDirectory, displayName, "-image", imageExtensions, 2).empty();
+}
+
 const std::string FileData::getThumbnailPath() const
 {
 	std::string thumbnail = metadata.get("thumbnail");
@@ -83,18 +182,7 @@ const std::string FileData::getThumbnailPath() const
 		
 		// no image, try to use local image
 		if(thumbnail.empty() && Settings::getInstance()->getBool("LocalArt"))
-		{
-			const char* extList[2] = { ".png", ".jpg" };
-			for(int i = 0; i < 2; i++)
-			{
-				if(thumbnail.empty())
-				{
-					std::string path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + "-image" + extList[i];
-					if(Utils::FileSystem::exists(path))
-						thumbnail = path;
-				}
-			}
-		}
+			thumbnail = findLocalMedia("-image", imageExtensions, 2);
 	}
 
 	return thumbnail;
@@ -136,11 +224,7 @@ const std::string FileData::getVideoPath() const
 	
 	// no video, try to use local video
 	if(video.empty() && Settings::getInstance()->getBool("LocalArt"))
-	{
-		std::string path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + "-video.mp4";
-		if (Utils::FileSystem::exists(path))
-			video = path;
-	}
+		video = findLocalMedia("-video", videoExtensions, 1);
 	
 	return video;
 }
@@ -151,18 +235,7 @@ const std::string FileData::getMarqueePath() const
 
 	// no marquee, try to use local marquee
 	if (marquee.empty() && Settings::getInstance()->getBool("LocalArt"))
-	{
-		const char* extList[2] = { ".png", ".jpg" };
-		for(int i = 0; i < 2; i++)
-		{
-			if(marquee.empty())
-			{
-				std::string path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + "-marquee" + extList[i];
-				if(Utils::FileSystem::exists(path))
-					marquee = path;
-			}
-		}
-	}
+		marquee = findLocalMedia("-marquee", imageExtensions, 2);
 
 	return marquee;
 }
@@ -173,18 +246,7 @@ const std::string FileData::getImagePath() const
 
 	// no image, try to use local image
 	if(image.empty())
-	{
-		const char* extList[2] = { ".png", ".jpg" };
-		for(int i = 0; i < 2; i++)
-		{
-			if(image.empty())
-			{
-				std::string path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + "-image" + extList[i];
-				if(Utils::FileSystem::exists(path))
-					image = path;
-			}
-		}
-	}
+		image = findLocalMedia("-image", imageExtensions, 2);
 
 	return image;
 }
@@ -197,7 +259,7 @@ const bool FileData::isArcadeAsset()
 {
 	if (mSystem && (mSystem->hasPlatformId(PlatformIds::ARCADE) || mSystem->hasPlatformId(PlatformIds::NEOGEO)))
 	{	
-		const std::string stem = Utils::FileSystem::getStem(getPath());
+		const std::string stem = getStem();
 		return MameNames::getInstance()->isBios(stem) || MameNames::getInstance()->isDevice(stem);		
 	}
 
@@ -222,7 +284,7 @@ void FileData::launchGame(Window* window)
 	std::string command = getSystemEnvData()->mLaunchCommand;
 
 	const std::string rom = Utils::FileSystem::getEscapedPath(getPath());
-	const std::string basename = Utils::FileSystem::getStem(getPath());
+	const std::string basename = getStem();
 	const std::string rom_raw = Utils::FileSystem::getPreferredPath(getPath());
 	
 	std::string emulator = getEmulator();
@@ -289,6 +351,9 @@ CollectionFileData::CollectionFileData(FileData* file, SystemData* system)
 {
 	mSourceFileData = file->getSourceFileData();
 	mParent = NULL;
+	mDirectory = mSourceFileData->mDirectory;
+	mFileName = mSourceFileData->mFileName;
+	mCatalogueId = mSourceFileData->mCatalogueId;
 	metadata = mSourceFileData->metadata;	
 	mDirty = true;
 }
@@ -298,11 +363,6 @@ SystemEnvironmentData* CollectionFileData::getSystemEnvData() const
 	return mSourceFileData->getSystemEnvData();
 }
 
-const std::string CollectionFileData::getPath() const
-{
-	return mSourceFileData->getPath();
-}
-
 std::string CollectionFileData::getSystemName() const
 {
 	return mSourceFileData->getSystem()->getName();
@@ -361,10 +421,21 @@ FolderData::SortType getSortTypeFromString(std::string desc) {
 	return FileSorts::SortTypes.at(0);
 }
 
-const std::vector<FileData*> FolderData::getChildrenListToDisplay() 
+std::atomic<unsigned int> FolderData::sDisplayListGeneration(0);
+
+void FolderData::invalidateDisplayList()
 {
-	std::vector<FileData*> ret;
+	for (FolderData* folder = this; folder != nullptr; folder = folder->getParent())
+		folder->mDisplayListValid = false;
+}
 
+void FolderData::invalidateAllDisplayLists()
+{
+	sDisplayListGeneration++;
+}
+
+const std::vector<FileData*> FolderData::getChildrenListToDisplay() 
+{
 	bool flatFolders = Settings::getInstance()->getBool("FlatFolders");
 	bool showHiddenFiles = Settings::getInstance()->getBool("ShowHiddenFiles");
 	bool filterKidGame = false;
@@ -380,6 +451,19 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 
 	auto sys = CollectionSystemManager::get()->getSystemToView(mSystem);
 
+	DisplayListKey key;
+	key.generation = sDisplayListGeneration;
+	key.system = sys;
+	key.sortId = flatFolders ? sys->getSortId() : 0;
+	key.flatFolders = flatFolders;
+	key.showHiddenFiles = showHiddenFiles;
+	key.filterKidGame = filterKidGame;
+
+	if (mDisplayListValid && mDisplayListKey == key)
+		return mDisplayList;
+
+	std::vector<FileData*> ret;
+
 	FileFilterIndex* idx = sys->getIndex(false);
 	if (idx != nullptr && !idx->isFiltered())
 		idx = nullptr;
@@ -407,6 +491,10 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 		ret.push_back(*it);
 	}
 
+	mDisplayList = ret;
+	mDisplayListKey = key;
+	mDisplayListValid = true;
+
 	return ret;
 }
 
@@ -431,40 +519,124 @@ std::vector<FileData*> FolderData::getFlatGameList(bool displayedOnly, SystemDat
 std::vector<FileData*> FolderData::getFilesRecursive(unsigned int typeMask, bool displayedOnly, SystemData* system) const
 {
 	std::vector<FileData*> out;
+	visitFiles(typeMask, [&out](FileData* file) { out.push_back(file); return true; }, displayedOnly, system);
+	return out;
+}
+
+// Returns the filter index to apply during a walk, if any
+FileFilterIndex* FolderData::getVisitFilter(bool displayedOnly, SystemData* system) const
+{
+	if (!displayedOnly)
+		return nullptr;
 
 	FileFilterIndex* idx = (system != nullptr ? system : mSystem)->getIndex(false);
+	if (idx == nullptr || !idx->isFiltered())
+		return nullptr;
 
-	for (auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+	return idx;
+}
+
+bool FolderData::visitFiles(unsigned int typeMask, const std::function<bool(FileData*)>& visitor, bool displayedOnly, SystemData* system) const
+{
+	return visitFilteredFiles(typeMask, visitor, getVisitFilter(displayedOnly, system));
+}
+
+bool FolderData::visitFilteredFiles(unsigned int typeMask, const std::function<bool(FileData*)>& visitor, FileFilterIndex* filter) const
+{
+	for (auto child : mChildren)
 	{
-		if ((*it)->getType() & typeMask)
-		{
-			if (!displayedOnly || idx == nullptr || !idx->isFiltered() || idx->showFile(*it))
-				out.push_back(*it);
-		}
+		if ((child->getType() & typeMask) && (filter == nullptr || filter->showFile(child)))
+			if (!visitor(child))
+				return false;
 
-		if ((*it)->getType() != FOLDER)
+		if (child->getType() == FOLDER && !((FolderData*)child)->mChildren.empty())
+			if (!((FolderData*)child)->visitFilteredFiles(typeMask, visitor, filter))
+				return false;
+	}
+
+	return true;
+}
+
+// Process-wide path -> FileData index of the system files (collection entries are indexed by their folder).
+// It's built on first lookup, then kept in sync by addChild & removeChild.
+static std::mutex sPathIndexLock;
+static std::unordered_multimap<std::string, FileData*> sPathIndex;
+static bool sPathIndexBuilt = false;
+
+static void buildPathIndex(FolderData* folder)
+{
+	for (auto child : folder->getChildren())
+	{
+		if (child->getSourceFileData() != child)
 			continue;
 
-		FolderData* folder = (FolderData*)(*it);
-		if (folder->getChildren().size() > 0)
+		sPathIndex.insert(std::make_pair(child->getPath(), child));
+
+		if (child->getType() == FOLDER)
+			buildPathIndex((FolderData*)child);
+	}
+}
+
+static void removeFromPathIndex(FileData* file)
+{
+	auto range = sPathIndex.equal_range(file->getPath());
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == file)
 		{
-			std::vector<FileData*> subchildren = folder->getFilesRecursive(typeMask, displayedOnly, system);
-			out.insert(out.cend(), subchildren.cbegin(), subchildren.cend());
+			sPathIndex.erase(it);
+			break;
 		}
 	}
+}
 
-	return out;
+void FolderData::resetPathIndex()
+{
+	std::unique_lock<std::mutex> lock(sPathIndexLock);
+	sPathIndex.clear();
+	sPathIndexBuilt = false;
 }
 
+FolderData::~FolderData()
+{
+	for (int i = mChildren.size() - 1; i >= 0; i--)
+		delete mChildren.at(i);
+
+	mChildren.clear();
+
+	delete mCollectionStatistics;
+}
+
 void FolderData::addChild(FileData* file)
 {
 	assert(mType == FOLDER);
 	assert(file->getParent() == NULL);
 
-	const std::string key = file->getKey();
-
 	mChildren.push_back(file);
-	file->setParent(this);	
+	file->setParent(this);
+	invalidateDisplayList();
+	mSystem->updateDisplayedGameCount();
+
+	if (file->getType() == FOLDER)
+		mFolderCount++;
+
+	FileData* source = file->getSourceFileData();
+	if (source != file)
+	{
+		mCollectionEntries[source] = file;
+
+		if (mCollectionStatistics != nullptr)
+			mCollectionStatistics->add(file);
+
+		return;
+	}
+
+	if (file->getType() == GAME)
+		GameCatalogue::getInstance()->update(file);
+
+	std::unique_lock<std::mutex> lock(sPathIndexLock);
+	if (sPathIndexBuilt)
+		sPathIndex.insert(std::make_pair(file->getPath(), file));
 }
 
 void FolderData::removeChild(FileData* file)
@@ -472,12 +644,37 @@ void FolderData::removeChild(FileData* file)
 	assert(mType == FOLDER);
 	assert(file->getParent() == this);
 
-	for (auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+	// searched from the end, as ~FolderData deletes the children from the last one
+	for (auto it = mChildren.rbegin(); it != mChildren.rend(); it++)
 	{
 		if (*it == file)
 		{
 			file->setParent(NULL);
-			mChildren.erase(it);
+			mChildren.erase(std::next(it).base());
+			invalidateDisplayList();
+			mSystem->updateDisplayedGameCount();
+
+			if (file->getType() == FOLDER)
+				mFolderCount--;
+
+			// don't use the source file, it may already be deleted
+			FileData* source = file->getSourceFileData();
+			if (source != file)
+			{
+				auto entry = mCollectionEntries.find(source);
+				if (entry != mCollectionEntries.cend() && entry->second == file)
+					mCollectionEntries.erase(entry);
+
+				if (mCollectionStatistics != nullptr)
+					mCollectionStatistics->remove(file);
+
+				return;
+			}
+
+			std::unique_lock<std::mutex> lock(sPathIndexLock);
+			if (sPathIndexBuilt)
+				removeFromPathIndex(file);
+
 			return;
 		}
 	}
@@ -490,6 +687,7 @@ void FolderData::removeChild(FileData* file)
 void FolderData::sort(ComparisonFunction& comparator, bool ascending)
 {
 	std::stable_sort(mChildren.begin(), mChildren.end(), comparator);
+	mDisplayListValid = false;
 
 	for (auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
 	{
@@ -511,35 +709,83 @@ void FolderData::sort(const SortType& type)
 	sort(*type.comparisonFunction, type.ascending);
 }
 
-FileData* FolderData::FindByPath(const std::string& path)
+void FolderData::enableCollectionStatistics()
+{
+	if (mCollectionStatistics != nullptr)
+		return;
+
+	mCollectionStatistics = new CollectionStatistics();
+
+	for (auto entry : mCollectionEntries)
+		mCollectionStatistics->add(entry.second);
+}
+
+void FolderData::updateCollectionStatistics(FileData* entry)
+{
+	if (mCollectionStatistics != nullptr && entry->getParent() == this)
+		mCollectionStatistics->add(entry);
+}
+
+void FolderData::resortChild(FileData* file, const SortType& type)
+{
+	// linear find & erase : O(n) comparisons of pointers, much cheaper than the comparisons of the sort
+	auto it = std::find(mChildren.begin(), mChildren.end(), file);
+	if (it == mChildren.end())
+		return;
+
+	mChildren.erase(it);
+
+	ComparisonFunction* comparator = type.comparisonFunction;
+	if (type.ascending)
+		it = std::upper_bound(mChildren.begin(), mChildren.end(), file, comparator);
+	else
+		it = std::upper_bound(mChildren.begin(), mChildren.end(), file, [comparator](const FileData* a, const FileData* b) { return comparator(b, a); });
+
+	// O(n) too : the following children are moved up
+	mChildren.insert(it, file);
+	mDisplayListValid = false;
+}
+
+std::vector<FileData*> FolderData::FindSystemFilesByPath(const std::string& path)
 {
-	std::vector<FileData*> children = getChildren();
+	std::vector<FileData*> files;
+
+	std::unique_lock<std::mutex> lock(sPathIndexLock);
 
-	for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it)
+	if (!sPathIndexBuilt)
 	{
-		if ((*it)->getPath() == path)
-			return (*it);
+		for (auto system : SystemData::sSystemVector)
+			if (!system->isCollection() && system->getRootFolder() != nullptr)
+				buildPathIndex(system->getRootFolder());
 
-		if ((*it)->getType() != FOLDER)
-			continue;
-		
-		auto item = ((FolderData*)(*it))->FindByPath(path);
-		if (item != nullptr)
-			return item;
+		sPathIndexBuilt = true;
 	}
 
-	return nullptr;
+	auto range = sPathIndex.equal_range(path);
+	for (auto it = range.first; it != range.second; ++it)
+		files.push_back(it->second);
+
+	return files;
 }
 
-void FolderData::createChildrenByFilenameMap(std::unordered_map<std::string, FileData*>& map)
+FileData* FolderData::FindBySourceFile(FileData* source)
 {
-	std::vector<FileData*> children = getChildren();
+	auto entry = mCollectionEntries.find(source);
+	if (entry != mCollectionEntries.cend())
+		return entry->second;
+
+	if (mFolderCount == 0)
+		return nullptr;
 
-	for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it)
+	for (auto child : mChildren)
 	{
-		if ((*it)->getType() == FOLDER)
-			((FolderData*)(*it))->createChildrenByFilenameMap(map);			
-		else 
-			map[(*it)->getKey()] = (*it);
-	}	
+		if (child->getType() != FOLDER)
+			continue;
+
+		FileData* item = ((FolderData*)child)->FindBySourceFile(source);
+		if (item != nullptr)
+			return item;
+	}
+
+	return nullptr;
 }
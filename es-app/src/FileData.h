@@ -4,8 +4,12 @@
 
 #include "utils/FileSystemUtil.h"
 #include "MetaData.h"
+#include <atomic>
+#include <functional>
 #include <unordered_map>
 
+class CollectionStatistics;
+class FileFilterIndex;
 class SystemData;
 class Window;
 struct SystemEnvironmentData;
@@ -34,6 +38,10 @@ public:
 	FileData(FileType type, const std::string& path, SystemData* system);
 	virtual ~FileData();
 
+	// The nodes come from the arena of the system being built when there's one, from the heap otherwise, see FileDataArena
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr);
+
 	virtual const std::string getName();
 
 	inline FileType getType() const { return mType; }
@@ -66,25 +74,46 @@ public:
 	virtual std::string getKey();
 	const bool isArcadeAsset();
 	inline std::string getFullPath() { return getPath(); };
-	inline std::string getFileName() { return Utils::FileSystem::getFileName(getPath()); };
+
+	// Cheap views on the stored path, without rebuilding it
+	inline const std::string& getFileName() const { return mFileName; };
+	std::string getStem() const;
+	std::string getExtension() const;
+
 	virtual FileData* getSourceFileData();
 	virtual std::string getSystemName() const;
 
+	// Row of the game in the GameCatalogue, -1 when it has none
+	inline int getCatalogueId() const { return mCatalogueId; }
+
 	// Returns our best guess at the "real" name for this file (will attempt to perform MAME name translation)
 	std::string getDisplayName() const;
 
 	// As above, but also remove parenthesis
 	std::string getCleanName() const;
 
+	// Local art lookups from copies of the media directory & display name, which don't read the file itself
+	static bool hasLocalVideo(const std::string& mediaDirectory, const std::string& displayName);
+	static bool hasLocalImage(const std::string& mediaDirectory, const std::string& displayName);
+
 	void launchGame(Window* window);
 
 	MetaDataList metadata;
 
 protected:	
+	friend class CollectionFileData;
+	friend class GameCatalogue;
+
+	std::string findLocalMedia(const std::string& suffix, const char** extensions, int count) const;
+
 	FolderData* mParent;
-	std::string mPath;
+
+	// The path is resolved once : the directory is interned & shared by all the files it holds (NULL when the path has none)
+	const std::string* mDirectory;
+	std::string mFileName;
 	FileType mType;
 	SystemData* mSystem;
+	int mCatalogueId;
 };
 
 class CollectionFileData : public FileData
@@ -96,7 +125,6 @@ public:
 	void refreshMetadata();
 	FileData* getSourceFileData();
 	std::string getKey();
-	virtual const std::string getPath() const;
 
 	virtual std::string getSystemName() const;
 	virtual SystemEnvironmentData* getSystemEnvData() const;
@@ -112,17 +140,11 @@ private:
 class FolderData : public FileData
 {
 public:
-	FolderData(const std::string& startpath, SystemData* system) : FileData(FOLDER, startpath, system)
+	FolderData(const std::string& startpath, SystemData* system) : FileData(FOLDER, startpath, system), mFolderCount(0), mCollectionStatistics(nullptr), mDisplayListValid(false)
 	{
 	}
 
-	~FolderData()
-	{
-		for (int i = mChildren.size() - 1; i >= 0; i--)
-			delete mChildren.at(i);
-
-		mChildren.clear();
-	}
+	~FolderData();
 
 	typedef bool ComparisonFunction(const FileData* a, const FileData* b);
 	struct SortType
@@ -138,21 +160,77 @@ public:
 	void sort(ComparisonFunction& comparator, bool ascending = true);
 	void sort(const SortType& type);
 
-	FileData* FindByPath(const std::string& path);
+	// Moves a child to its place in this folder, already sorted by type, rather than sorting it all again.
+	// The place is found by binary search, but moving it in mChildren (a vector) is still O(n) : it only saves the O(n log n) sort
+	void resortChild(FileData* file, const SortType& type);
+
+	// Returns the files of all the systems (not the collections) with this path, using the path index
+	static std::vector<FileData*> FindSystemFilesByPath(const std::string& path);
+
+	// Returns the collection entry of this folder pointing to source, if any
+	FileData* FindBySourceFile(FileData* source);
+
+	// Forgets the path index, before deleting all the systems
+	static void resetPathIndex();
+
+	// Aggregated metadata of the collection entries of this folder, kept up to date by addChild & removeChild.
+	// Only the collections that show them in their folder metadata enable them : NULL otherwise
+	inline const CollectionStatistics* getCollectionStatistics() const { return mCollectionStatistics; }
+	void enableCollectionStatistics();
+	// To call when the metadata of a collection entry changed
+	void updateCollectionStatistics(FileData* entry);
 
 	inline const std::vector<FileData*>& getChildren() const { return mChildren; }
 	const std::vector<FileData*> getChildrenListToDisplay();
+
+	// Drops the memoised display list of this folder & its parents (their flat lists include our children)
+	void invalidateDisplayList();
+	// Drops all the memoised display lists, when the filters or the metadata used to sort them change
+	static void invalidateAllDisplayLists();
 	std::vector<FileData*> getFilesRecursive(unsigned int typeMask, bool displayedOnly = false, SystemData* system = nullptr) const;
 
+	// Calls visitor on each file matching typeMask, depth first, without building any list. The walk stops as soon as visitor returns false.
+	bool visitFiles(unsigned int typeMask, const std::function<bool(FileData*)>& visitor, bool displayedOnly = false, SystemData* system = nullptr) const;
+
 	void addChild(FileData* file); // Error if mType != FOLDER
 	void removeChild(FileData* file); //Error if mType != FOLDER
 
-	void createChildrenByFilenameMap(std::unordered_map<std::string, FileData*>& map);
-
 private:
 	std::vector<FileData*> getFlatGameList(bool displayedOnly, SystemData* system) const;
 
+	FileFilterIndex* getVisitFilter(bool displayedOnly, SystemData* system) const;
+	bool visitFilteredFiles(unsigned int typeMask, const std::function<bool(FileData*)>& visitor, FileFilterIndex* filter) const;
+
 	std::vector<FileData*> mChildren;
+
+	// Collection entries (CollectionFileData) of this folder, by source file
+	std::unordered_map<FileData*, FileData*> mCollectionEntries;
+	int mFolderCount;
+
+	CollectionStatistics* mCollectionStatistics;
+
+	// What getChildrenListToDisplay depends on : the memoised list is rebuilt as soon as one of them differs
+	struct DisplayListKey
+	{
+		unsigned int generation;
+		SystemData* system;
+		unsigned int sortId;
+		bool flatFolders;
+		bool showHiddenFiles;
+		bool filterKidGame;
+
+		bool operator==(const DisplayListKey& other) const
+		{
+			return generation == other.generation && system == other.system && sortId == other.sortId &&
+				flatFolders == other.flatFolders && showHiddenFiles == other.showHiddenFiles && filterKidGame == other.filterKidGame;
+		}
+	};
+
+	bool mDisplayListValid;
+	DisplayListKey mDisplayListKey;
+	std::vector<FileData*> mDisplayList;
+
+	static std::atomic<unsigned int> sDisplayListGeneration;
 };
 
 FolderData::SortType getSortTypeFromString(std::string desc);
@@ -0,0 +1,78 @@
+#include "FileDataArena.h"
+
+#include <new>
+
+#define ARENA_BLOCK_SIZE	(256 * 1024)
+#define ARENA_ALIGNMENT		16
+
+static thread_local FileDataArena* sCurrentArena = nullptr;
+
+FileDataArena::Scope::Scope(FileDataArena* arena) : mPrevious(sCurrentArena)
+{
+	sCurrentArena = arena;
+}
+
+FileDataArena::Scope::~Scope()
+{
+	sCurrentArena = mPrevious;
+}
+
+FileDataArena* FileDataArena::getCurrent()
+{
+	return sCurrentArena;
+}
+
+FileDataArena::FileDataArena() : mBlockUsed(0), mBlockSize(0), mSize(0), mAllocations(0), mReleased(0), mFreeCount(0)
+{
+}
+
+FileDataArena::~FileDataArena()
+{
+	for (auto block : mBlocks)
+		::operator delete(block);
+}
+
+// Only called on the thread building the tree, see Scope
+void* FileDataArena::allocate(size_t size)
+{
+	size = (size + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1);
+
+	if (mFreeCount > 0)
+	{
+		std::unique_lock<std::mutex> lock(mFreeLock);
+
+		auto it = mFreeNodes.find(size);
+		if (it != mFreeNodes.cend() && !it->second.empty())
+		{
+			void* ret = it->second.back();
+			it->second.pop_back();
+			mFreeCount--;
+			mAllocations++;
+			return ret;
+		}
+	}
+
+	if (mBlocks.empty() || mBlockUsed + size > mBlockSize)
+	{
+		// the end of the current block is given up, the nodes are small enough for it not to matter
+		mBlockSize = (size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE);
+		mBlocks.push_back((char*)::operator new(mBlockSize));
+		mBlockUsed = 0;
+		mSize += mBlockSize;
+	}
+
+	void* ret = mBlocks.back() + mBlockUsed;
+	mBlockUsed += size;
+	mAllocations++;
+	return ret;
+}
+
+void FileDataArena::release(void* ptr, size_t size)
+{
+	size = (size + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1);
+
+	std::unique_lock<std::mutex> lock(mFreeLock);
+	mFreeNodes[size].push_back(ptr);
+	mFreeCount++;
+	mReleased++;
+}
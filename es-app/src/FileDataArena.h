@@ -0,0 +1,58 @@
+#pragma once
+#ifndef ES_APP_FILE_DATA_ARENA_H
+#define ES_APP_FILE_DATA_ARENA_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <stddef.h>
+#include <vector>
+
+// Memory for the FileData tree of a system : the nodes are carved out of large blocks, all freed with the arena.
+// A deleted node goes to a free list of its size and is reused by the next node of that size, so that collections
+// repopulated during the session don't grow the arena.
+// FileData::operator new uses the arena made current on the calling thread by a Scope, or the heap when there's none :
+// the nodes created at runtime outside of a Scope (favorites, last played, custom collection edits) live on the heap.
+class FileDataArena
+{
+public:
+	class Scope
+	{
+	public:
+		Scope(FileDataArena* arena);
+		~Scope();
+
+	private:
+		FileDataArena* mPrevious;
+	};
+
+	FileDataArena();
+	~FileDataArena();
+
+	void* allocate(size_t size);
+	void release(void* ptr, size_t size);
+
+	static FileDataArena* getCurrent();
+
+	inline size_t getAllocationCount() const { return mAllocations; }
+	inline size_t getLiveCount() const { return mAllocations - mReleased; }
+	inline size_t getFreeCount() const { return mFreeCount; }
+	inline size_t getBlockCount() const { return mBlocks.size(); }
+	inline size_t getSize() const { return mSize; }
+
+private:
+	std::vector<char*> mBlocks;
+	size_t mBlockUsed;
+	size_t mBlockSize;
+	size_t mSize;
+
+	size_t mAllocations;
+	std::atomic<size_t> mReleased;
+
+	// Deleted nodes by size. Nodes may be deleted from any thread
+	std::mutex mFreeLock;
+	std::map<size_t, std::vector<void*>> mFreeNodes;
+	std::atomic<size_t> mFreeCount;
+};
+
+#endif // ES_APP_FILE_DATA_ARENA_H
@@ -204,6 +204,8 @@ void FileFilterIndex::removeFromIndex(FileData* game)
 void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>* values)
 {
 	// test if it exists before setting
+	FolderData::invalidateAllDisplayLists();
+
 	if(type == NONE)
 	{
 		clearAllFilters();
@@ -230,6 +232,8 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 
 void FileFilterIndex::clearAllFilters()
 {
+	FolderData::invalidateAllDisplayLists();
+
 	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
 	{
 		FilterDataDecl filterData = (*it);
@@ -292,6 +296,7 @@ void FileFilterIndex::debugPrintIndexes()
 void FileFilterIndex::setTextFilter(const std::string text)
 {
 	mTextFilter = Utils::String::toUpper(text);
+	FolderData::invalidateAllDisplayLists();
 }
 
 bool FileFilterIndex::showFile(FileData* game)
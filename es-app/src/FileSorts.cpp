@@ -1,6 +1,7 @@
 #include "FileSorts.h"
 
 #include "utils/StringUtil.h"
+#include "GameCatalogue.h"
 
 namespace FileSorts
 {
@@ -38,9 +39,21 @@ namespace FileSorts
 
 	const std::vector<FolderData::SortType> SortTypes(typesArr, typesArr + sizeof(typesArr)/sizeof(typesArr[0]));
 
+	// the games are compared on their GameCatalogue rows, the folders on their metadata
+	static inline bool haveCatalogueRows(const FileData* file1, const FileData* file2)
+	{
+		return file1->getCatalogueId() >= 0 && file2->getCatalogueId() >= 0;
+	}
+
 	//returns if file1 should come before file2
 	bool compareName(const FileData* file1, const FileData* file2)
 	{
+		if (haveCatalogueRows(file1, file2))
+		{
+			GameCatalogue* catalogue = GameCatalogue::getInstance();
+			return catalogue->getNameKey(file1->getCatalogueId()) < catalogue->getNameKey(file2->getCatalogueId());
+		}
+
 		std::string name1 = Utils::String::toUpper(file1->metadata.getName());
 		std::string name2 = Utils::String::toUpper(file2->metadata.getName());
 		return name1.compare(name2) < 0;
@@ -48,12 +61,24 @@ namespace FileSorts
 
 	bool compareRating(const FileData* file1, const FileData* file2)
 	{
+		if (haveCatalogueRows(file1, file2))
+		{
+			GameCatalogue* catalogue = GameCatalogue::getInstance();
+			return catalogue->getRating(file1->getCatalogueId()) < catalogue->getRating(file2->getCatalogueId());
+		}
+
 		return file1->metadata.getFloat("rating") < file2->metadata.getFloat("rating");
 	}
 
 	bool compareTimesPlayed(const FileData* file1, const FileData* file2)
 	{
 		//only games have playcount metadata
+		if (haveCatalogueRows(file1, file2))
+		{
+			GameCatalogue* catalogue = GameCatalogue::getInstance();
+			return catalogue->getPlayCount(file1->getCatalogueId()) < catalogue->getPlayCount(file2->getCatalogueId());
+		}
+
 		if(file1->metadata.getType() == GAME_METADATA && file2->metadata.getType() == GAME_METADATA)
 		{
 			return (file1)->metadata.getInt("playcount") < (file2)->metadata.getInt("playcount");
@@ -64,9 +89,14 @@ namespace FileSorts
 
 	bool compareLastPlayed(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->metadata.get("lastplayed") < (file2)->metadata.get("lastplayed");
+		if (haveCatalogueRows(file1, file2))
+		{
+			GameCatalogue* catalogue = GameCatalogue::getInstance();
+			return catalogue->getLastPlayed(file1->getCatalogueId()) < catalogue->getLastPlayed(file2->getCatalogueId());
+		}
+
+		// dates are stored packed, as integers which sort like their ISO strings (YYYYMMDDTHHMMSS)
+		return (file1)->metadata.getDate("lastplayed") < (file2)->metadata.getDate("lastplayed");
 	}
 
 	bool compareNumPlayers(const FileData* file1, const FileData* file2)
@@ -76,9 +106,14 @@ namespace FileSorts
 
 	bool compareReleaseDate(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->metadata.get("releasedate") < (file2)->metadata.get("releasedate");
+		if (haveCatalogueRows(file1, file2))
+		{
+			GameCatalogue* catalogue = GameCatalogue::getInstance();
+			return catalogue->getReleaseDate(file1->getCatalogueId()) < catalogue->getReleaseDate(file2->getCatalogueId());
+		}
+
+		// unknown dates ("not-a-date-time") come after all the others, as when they were compared as strings
+		return (file1)->metadata.getDate("releasedate", GameCatalogue::UNKNOWN_DATE) < (file2)->metadata.getDate("releasedate", GameCatalogue::UNKNOWN_DATE);
 	}
 
 	bool compareGenre(const FileData* file1, const FileData* file2)
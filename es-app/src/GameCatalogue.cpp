@@ -0,0 +1,160 @@
+#include "GameCatalogue.h"
+
+#include "utils/StringUtil.h"
+#include "FileData.h"
+#include "SystemData.h"
+
+GameCatalogue* GameCatalogue::sInstance = nullptr;
+
+GameCatalogue* GameCatalogue::getInstance()
+{
+	if (sInstance == nullptr)
+		sInstance = new GameCatalogue();
+
+	return sInstance;
+}
+
+unsigned short GameCatalogue::getSystemId(SystemData* system)
+{
+	auto it = mSystemIds.find(system);
+	if (it != mSystemIds.cend())
+		return it->second;
+
+	unsigned short id = (unsigned short)(mSystemIds.size() + 1);
+	mSystemIds[system] = id;
+	return id;
+}
+
+void GameCatalogue::update(FileData* file)
+{
+	// the collection entries share the row of their source file
+	if (file->getType() != GAME || file->getSourceFileData() != file || mLoading)
+		return;
+
+	const MetaDataList& md = file->metadata;
+
+	std::string nameKey = Utils::String::toUpper(md.getName());
+
+	unsigned char flags = 0;
+	if (md.get("favorite") == "true") flags |= FAVORITE;
+	if (md.get("hidden") == "true") flags |= HIDDEN;
+	if (md.get("kidgame") == "true") flags |= KIDGAME;
+	if (!md.get("image").empty()) flags |= HAS_IMAGE;
+	if (!md.get("video").empty()) flags |= HAS_VIDEO;
+	if (!md.get("marquee").empty()) flags |= HAS_MARQUEE;
+	if (!md.get("thumbnail").empty()) flags |= HAS_THUMBNAIL;
+
+	float rating = md.getFloat("rating");
+	int playCount = md.getInt("playcount");
+	long long lastPlayed = md.getDate("lastplayed");
+	long long releaseDate = md.getDate("releasedate", UNKNOWN_DATE);
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	// an id given before clear() is stale
+	int id = file->mCatalogueId;
+	if (id < 0 || id >= (int)mFiles.size() || mFiles[id] != file)
+	{
+		if (!mFreeRows.empty())
+		{
+			id = mFreeRows.back();
+			mFreeRows.pop_back();
+			mFiles[id] = file;
+		}
+		else
+		{
+			id = (int)mFiles.size();
+
+			mFiles.push_back(file);
+			mNameKeys.push_back("");
+			mSystems.push_back(0);
+			mRatings.push_back(0);
+			mPlayCounts.push_back(0);
+			mLastPlayed.push_back(0);
+			mReleaseDates.push_back(0);
+			mFlags.push_back(0);
+		}
+
+		file->mCatalogueId = id;
+	}
+
+	mNameKeys[id] = nameKey;
+	mSystems[id] = getSystemId(file->getSystem());
+	mRatings[id] = rating;
+	mPlayCounts[id] = playCount;
+	mLastPlayed[id] = lastPlayed;
+	mReleaseDates[id] = releaseDate;
+	mFlags[id] = flags;
+}
+
+void GameCatalogue::beginLoading()
+{
+	mLoading = true;
+}
+
+void GameCatalogue::endLoading(const std::vector<SystemData*>& systems)
+{
+	mLoading = false;
+
+	for (auto system : systems)
+	{
+		if (system->isCollection())
+			continue;
+
+		system->getRootFolder()->visitFiles(GAME, [this](FileData* file) { update(file); return true; });
+		system->updateDisplayedGameCount();
+	}
+}
+
+void GameCatalogue::clear()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	mFiles.clear();
+	mNameKeys.clear();
+	mSystems.clear();
+	mRatings.clear();
+	mPlayCounts.clear();
+	mLastPlayed.clear();
+	mReleaseDates.clear();
+	mFlags.clear();
+
+	mFreeRows.clear();
+	mSystemIds.clear();
+}
+
+void GameCatalogue::remove(FileData* file)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	// the rows may have been cleared before the files are deleted
+	int id = file->mCatalogueId;
+	if (id < 0 || id >= (int)mFiles.size() || mFiles[id] != file)
+		return;
+
+	mFiles[id] = nullptr;
+	mNameKeys[id].clear();
+	mSystems[id] = 0;
+	mFlags[id] = 0;
+	mFreeRows.push_back(id);
+
+	file->mCatalogueId = -1;
+}
+
+int GameCatalogue::countGames(SystemData* system, unsigned char flags)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	unsigned short systemId = getSystemId(system);
+
+	// plain loop over the two byte columns, which the compiler can vectorize
+	const unsigned short* systems = mSystems.data();
+	const unsigned char* rowFlags = mFlags.data();
+	size_t size = mSystems.size();
+
+	int count = 0;
+	for (size_t i = 0; i < size; i++)
+		count += (systems[i] == systemId) & ((rowFlags[i] & flags) == flags);
+
+	return count;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#ifndef ES_APP_GAME_CATALOGUE_H
+#define ES_APP_GAME_CATALOGUE_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class FileData;
+class SystemData;
+
+// Column copy of the metadata the sorts & scans read the most, with one row per game of the systems (not of the collections).
+// The row of a game is its ordinal (FileData::getCatalogueId), shared by the collection entries pointing to it.
+// Rows are filled when the games join their system & refreshed by update() whenever their metadata is changed.
+// The columns are written & read on the main thread only (the scraper posts its changes there) : the sorts read them unlocked.
+// While the systems are loaded on several threads, no row is given : endLoading gives them once the threads are done.
+// Until then, the sorts fall back to the metadata.
+class GameCatalogue
+{
+public:
+	enum Flags : unsigned char
+	{
+		FAVORITE = 1,
+		HIDDEN = 2,
+		KIDGAME = 4,
+		HAS_IMAGE = 8,
+		HAS_VIDEO = 16,
+		HAS_MARQUEE = 32,
+		HAS_THUMBNAIL = 64
+	};
+
+	static GameCatalogue* getInstance();
+
+	// Gives the game a row if it has none yet, then copies its metadata into it
+	void update(FileData* file);
+	void remove(FileData* file);
+
+	void beginLoading();
+	void endLoading(const std::vector<SystemData*>& systems);
+
+	// Forgets all the rows & system ids, before deleting all the systems
+	void clear();
+
+	inline const std::string& getNameKey(int id) const { return mNameKeys[id]; }
+	inline float getRating(int id) const { return mRatings[id]; }
+	inline int getPlayCount(int id) const { return mPlayCounts[id]; }
+	inline long long getLastPlayed(int id) const { return mLastPlayed[id]; }
+	inline long long getReleaseDate(int id) const { return mReleaseDates[id]; }
+	inline bool hasFlags(int id, unsigned char flags) const { return (mFlags[id] & flags) == flags; }
+
+	// Number of games of the system having all the flags
+	int countGames(SystemData* system, unsigned char flags = 0);
+
+	// Release date of the games without one, sorted last
+	static const long long UNKNOWN_DATE = 99999999999999LL;
+
+private:
+	GameCatalogue() : mLoading(false) { }
+
+	unsigned short getSystemId(SystemData* system);
+
+	static GameCatalogue* sInstance;
+
+	std::mutex mLock;
+	std::atomic<bool> mLoading;
+
+	std::vector<FileData*> mFiles;
+	std::vector<std::string> mNameKeys; // upper case names
+	std::vector<unsigned short> mSystems; // 0 for the free rows
+	std::vector<float> mRatings;
+	std::vector<int> mPlayCounts;
+	std::vector<long long> mLastPlayed;
+	std::vector<long long> mReleaseDates;
+	std::vector<unsigned char> mFlags;
+
+	std::vector<int> mFreeRows;
+	std::unordered_map<SystemData*, unsigned short> mSystemIds; // system -> id, from 1
+};
+
+#endif // ES_APP_GAME_CATALOGUE_H
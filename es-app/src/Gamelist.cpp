@@ -4,6 +4,7 @@
 #include "utils/StringUtil.h"
 #include "FileData.h"
 #include "FileFilterIndex.h"
+#include "GameCatalogue.h"
 #include "Log.h"
 #include "Settings.h"
 #include "SystemData.h"
@@ -160,6 +161,7 @@ void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*
 				file->metadata.set("hidden", "true");
 
 			file->metadata.resetChangedFlag();
+			GameCatalogue::getInstance()->update(file);
 		}
 	}
 }
@@ -199,6 +201,7 @@ void updateGamelist(SystemData* system)
 		return;
 
 	int numUpdated = 0;
+	std::vector<FileData*> written;
 
 	pugi::xml_document doc;
 	pugi::xml_node root;
@@ -231,17 +234,15 @@ void updateGamelist(SystemData* system)
 	FolderData* rootFolder = system->getRootFolder();
 	if (rootFolder != nullptr)
 	{
-		//get only files, no folders
-		std::vector<FileData*> files = rootFolder->getFilesRecursive(GAME | FOLDER);
-		//iterate through all files, checking if they're already in the XML
+		// do not touch the files which weren't changed anyway
+		std::vector<FileData*> files;
+		rootFolder->visitFiles(GAME | FOLDER, [&files](FileData* file) { if (file->metadata.wasChanged()) files.push_back(file); return true; });
+
+		//iterate through the changed files, checking if they're already in the XML
 		for(std::vector<FileData*>::const_iterator fit = files.cbegin(); fit != files.cend(); ++fit)
 		{
 			const char* tag = ((*fit)->getType() == GAME) ? "game" : "folder";
 
-			// do not touch if it wasn't changed anyway
-			if (!(*fit)->metadata.wasChanged())
-				continue;
-
 			bool removed = false;
 
 			// check if the file already exists in the XML
@@ -271,6 +272,8 @@ void updateGamelist(SystemData* system)
 				++numUpdated; // Only if really added
 			else if (removed)
 				++numUpdated; // Only if really removed
+
+			written.push_back(*fit);
 		}
 
 		//now write the file
@@ -316,6 +319,12 @@ void updateGamelist(SystemData* system)
 					// rename gamelist.tmp.xml to gamelist.xml
 					if (std::rename(tmpFile.c_str(), xmlWritePath.c_str()) != 0)
 						LOG(LogError) << "Unable to rename \"" << tmpFile << "to " << xmlWritePath << "\"!";
+					else
+					{
+						// Saved : don't write them again on next update
+						for (auto file : written)
+							file->metadata.resetChangedFlag();
+					}
 
 				}
 				else 
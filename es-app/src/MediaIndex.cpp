@@ -0,0 +1,266 @@
+#include "MediaIndex.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include <chrono>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// The pending changes are read at most this often, not on every lookup
+#define EVENTS_POLL_INTERVAL_MS	50
+
+MediaIndex* MediaIndex::sInstance = nullptr;
+
+MediaIndex* MediaIndex::getInstance()
+{
+	if (!sInstance)
+		sInstance = new MediaIndex();
+
+	return sInstance;
+}
+
+void MediaIndex::deinit()
+{
+	if (sInstance)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+}
+
+MediaIndex::MediaIndex()
+{
+	mNotifyFd = -1;
+	mLastPoll = 0;
+
+#if defined(__linux__)
+	mNotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (mNotifyFd < 0)
+		LOG(LogWarning) << "MediaIndex : inotify is not available, local media changes will be seen after a reload";
+#endif
+}
+
+MediaIndex::~MediaIndex()
+{
+	clear();
+
+#if defined(__linux__)
+	if (mNotifyFd >= 0)
+		close(mNotifyFd);
+#endif
+}
+
+void MediaIndex::clear()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	forgetDirectories();
+}
+
+void MediaIndex::forgetDirectories()
+{
+#if defined(__linux__)
+	if (mNotifyFd >= 0)
+	{
+		for (auto it = mWatches.cbegin(); it != mWatches.cend(); it++)
+			inotify_rm_watch(mNotifyFd, it->first);
+
+		for (auto it = mParentWatches.cbegin(); it != mParentWatches.cend(); it++)
+			if (mWatches.find(it->first) == mWatches.cend())
+				inotify_rm_watch(mNotifyFd, it->first);
+	}
+#endif
+
+	mWatches.clear();
+	mParentWatches.clear();
+	mDirectories.clear();
+}
+
+std::string MediaIndex::getKey(const std::string& fileName)
+{
+#if defined(_WIN32)
+	return Utils::String::toLower(fileName);
+#else
+	return fileName;
+#endif
+}
+
+MediaIndex::Directory& MediaIndex::getDirectory(const std::string& directory)
+{
+	auto it = mDirectories.find(directory);
+	if (it != mDirectories.cend())
+		return it->second;
+
+	Directory& dir = mDirectories[directory];
+
+#if defined(__linux__)
+	// Watch before listing, so a file created in between isn't missed
+	if (mNotifyFd >= 0)
+	{
+		dir.watch = inotify_add_watch(mNotifyFd, directory.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+		if (dir.watch >= 0)
+			mWatches[dir.watch] = directory;
+		else if (errno == ENOENT)
+		{
+			// Not created yet : cached as empty only while its creation can be seen
+			if (!watchParent(directory))
+			{
+				mDirectories.erase(directory);
+				return mNoDirectory;
+			}
+
+			dir.missing = true;
+			return dir;
+		}
+	}
+#endif
+
+	for (auto file : Utils::FileSystem::getDirInfo(directory))
+		if (!file.directory)
+			dir.files.insert(getKey(Utils::FileSystem::getFileName(file.path)));
+
+	return dir;
+}
+
+bool MediaIndex::watchParent(const std::string& directory)
+{
+#if defined(__linux__)
+	// IN_MASK_ADD : the parent may be a watched media folder too
+	std::string parent = Utils::FileSystem::getParent(directory);
+	int watch = inotify_add_watch(mNotifyFd, parent.c_str(), IN_CREATE | IN_MOVED_TO | IN_ONLYDIR | IN_MASK_ADD);
+	if (watch < 0)
+		return false;
+
+	mParentWatches[watch].push_back(directory);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void MediaIndex::processEvents()
+{
+#if defined(__linux__)
+	if (mNotifyFd < 0 || (mWatches.size() == 0 && mParentWatches.size() == 0))
+		return;
+
+	long long now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	if (now - mLastPoll < EVENTS_POLL_INTERVAL_MS)
+		return;
+
+	mLastPoll = now;
+
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	ssize_t len;
+	while ((len = read(mNotifyFd, buffer, sizeof(buffer))) > 0)
+	{
+		for (char* ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + ((struct inotify_event*) ptr)->len)
+		{
+			const struct inotify_event* event = (const struct inotify_event*) ptr;
+
+			// Some events were lost : the folders are listed again on next use
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				LOG(LogWarning) << "MediaIndex : inotify queue overflow, local media folders will be listed again";
+
+				forgetDirectories();
+				while (read(mNotifyFd, buffer, sizeof(buffer)) > 0);
+				return;
+			}
+
+			// A missing folder was created, or the parent is gone : the folders are listed again on next use
+			auto parent = mParentWatches.find(event->wd);
+			if (parent != mParentWatches.cend())
+			{
+				auto& missing = parent->second;
+
+				for (auto it = missing.begin(); it != missing.end(); )
+				{
+					if ((event->mask & IN_IGNORED) || ((event->mask & IN_ISDIR) && event->len > 0 && Utils::FileSystem::getFileName(*it) == event->name))
+					{
+						auto dir = mDirectories.find(*it);
+						if (dir != mDirectories.cend() && dir->second.missing)
+							mDirectories.erase(dir);
+
+						it = missing.erase(it);
+					}
+					else
+						it++;
+				}
+
+				if (event->mask & IN_IGNORED)
+					mParentWatches.erase(parent);
+			}
+
+			auto watch = mWatches.find(event->wd);
+			if (watch == mWatches.cend())
+				continue;
+
+			auto dir = mDirectories.find(watch->second);
+			if (dir == mDirectories.cend())
+				continue;
+
+			// The folder itself is gone : forget it, it will be listed again on next use
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+			{
+				if (!(event->mask & IN_IGNORED))
+					inotify_rm_watch(mNotifyFd, event->wd);
+
+				mDirectories.erase(dir);
+				mWatches.erase(watch);
+				continue;
+			}
+
+			if (event->len == 0 || (event->mask & IN_ISDIR))
+				continue;
+
+			std::string name = getKey(event->name);
+
+			if (event->mask & (IN_CREATE | IN_MOVED_TO))
+				dir->second.files.insert(name);
+			else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+				dir->second.files.erase(name);
+		}
+	}
+#endif
+}
+
+void MediaIndex::preloadDirectory(const std::string& directory)
+{
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		if (mDirectories.find(directory) != mDirectories.cend())
+			return;
+	}
+
+	// Fills the system caches : listing it again below, under the lock, is then cheap
+	Utils::FileSystem::getDirInfo(directory);
+
+	std::unique_lock<std::mutex> lock(mLock);
+	getDirectory(directory);
+}
+
+std::string MediaIndex::findMedia(const std::string& directory, const std::string& stem, const std::string& suffix, const char** extensions, int count)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	processEvents();
+
+	Directory& dir = getDirectory(directory);
+	if (dir.files.size() == 0)
+		return "";
+
+	for (int i = 0; i < count; i++)
+	{
+		std::string fileName = stem + suffix + extensions[i];
+		if (dir.files.find(getKey(fileName)) != dir.files.cend())
+			return directory + "/" + fileName;
+	}
+
+	return "";
+}
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef ES_APP_MEDIA_INDEX_H
+#define ES_APP_MEDIA_INDEX_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Remembers the content of local media folders (<system>/images), so looking for local art doesn't hit the disk.
+// Each folder is listed once on first use, then kept up to date with inotify where available (listed again if events were lost).
+// A missing folder is remembered as empty while its parent is watched, so it's listed as soon as it's created.
+class MediaIndex
+{
+public:
+	static MediaIndex* getInstance();
+	static void deinit();
+
+	// Returns the path of <directory>/<stem><suffix><ext> for the first of extensions that exists, or an empty string
+	std::string findMedia(const std::string& directory, const std::string& stem, const std::string& suffix, const char** extensions, int count);
+
+	// Lists the folder ahead of its first lookup. The disk is read without the lock, so the lookups of the other threads don't wait for it.
+	void preloadDirectory(const std::string& directory);
+
+	void clear();
+
+private:
+	MediaIndex();
+	~MediaIndex();
+
+	struct Directory
+	{
+		Directory() : watch(-1), missing(false) { }
+
+		std::unordered_set<std::string> files;
+		int watch;
+		bool missing;
+	};
+
+	Directory& getDirectory(const std::string& directory);
+	void processEvents();
+	bool watchParent(const std::string& directory);
+	void forgetDirectories();
+
+	static std::string getKey(const std::string& fileName);
+
+	static MediaIndex* sInstance;
+
+	std::mutex mLock;
+	std::unordered_map<std::string, Directory> mDirectories;
+	std::unordered_map<int, std::string> mWatches;
+	std::unordered_map<int, std::vector<std::string>> mParentWatches; // parent watch -> missing folders in it
+	Directory mNoDirectory; // returned for the missing folders that can't be watched
+	int mNotifyFd;
+	long long mLastPoll; // ms
+};
+
+#endif // ES_APP_MEDIA_INDEX_H
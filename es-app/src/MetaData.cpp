@@ -6,6 +6,7 @@
 #include <pugixml/src/pugixml.hpp>
 #include "SystemData.h"
 #include "Settings.h"
+#include <stdio.h>
 
 MetaDataDecl gameDecls[] = {
 	// key,         type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
@@ -111,6 +112,41 @@ unsigned char MetaDataList::getId(const std::string& key) const
 	return mFolderIdMap[key];
 }
 
+// "YYYYMMDDTHHMMSS" <-> YYYYMMDDHHMMSS : anything else isn't packed
+static bool packDate(const std::string& value, long long& packed)
+{
+	if (value.size() != 15 || value[8] != 'T')
+		return false;
+
+	long long ret = 0;
+
+	for (size_t i = 0; i < value.size(); i++)
+	{
+		if (i == 8)
+			continue;
+
+		if (value[i] < '0' || value[i] > '9')
+			return false;
+
+		ret = ret * 10 + (value[i] - '0');
+	}
+
+	packed = ret;
+	return true;
+}
+
+static std::string unpackDate(long long packed)
+{
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%08lldT%06lld", packed / 1000000, packed % 1000000);
+	return buf;
+}
+
+static inline bool isDateType(MetaDataType type)
+{
+	return type == MD_DATE || type == MD_TIME;
+}
+
 const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
 {
 	switch(type)
@@ -155,8 +191,12 @@ MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node&
 			if (iter->type == MD_BOOL)
 				value = Utils::String::toLower(value);
 
+			long long packed;
+
 			if (iter->id == 0)
 				mdl.mName = value;
+			else if (isDateType(iter->type) && packDate(value, packed))
+				mdl.mDates[iter->id] = packed;
 			else
 				mdl.mMap[iter->id] = value;
 		}
@@ -177,6 +217,13 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 			continue;
 		}
 
+		auto dateIter = mDates.find(mddIter->id);
+		if (dateIter != mDates.cend())
+		{
+			parent.append_child(mddIter->key.c_str()).text().set(unpackDate(dateIter->second).c_str());
+			continue;
+		}
+
 		auto mapIter = mMap.find(mddIter->id);
 		if (mapIter != mMap.cend())
 		{
@@ -212,12 +259,26 @@ void MetaDataList::set(const std::string& key, const std::string& value)
 	else
 	{
 		auto id = getId(key);
-		
-		auto prev = mMap.find(id);
-		if (prev != mMap.cend() && prev->second == value)
-			return;
 
-		mMap[id] = value;
+		long long packed;
+		if (isDateType(getType(id)) && packDate(value, packed))
+		{
+			auto prev = mDates.find(id);
+			if (prev != mDates.cend() && prev->second == packed)
+				return;
+
+			mDates[id] = packed;
+			mMap.erase(id);
+		}
+		else
+		{
+			auto prev = mMap.find(id);
+			if (prev != mMap.cend() && prev->second == value)
+				return;
+
+			mMap[id] = value;
+			mDates.erase(id);
+		}
 	}
 
 	mWasChanged = true;
@@ -230,6 +291,13 @@ const std::string MetaDataList::get(const std::string& key) const
 
 	auto id = getId(key);
 
+	if (!mDates.empty())
+	{
+		auto dateIt = mDates.find(id);
+		if (dateIt != mDates.cend())
+			return unpackDate(dateIt->second);
+	}
+
 	auto it = mMap.find(id);
 	if (it != mMap.end())
 	{		
@@ -255,6 +323,20 @@ float MetaDataList::getFloat(const std::string& key) const
 	return (float)atof(get(key).c_str());
 }
 
+long long MetaDataList::getDate(const std::string& key, long long defaultValue) const
+{
+	auto it = mDates.find(getId(key));
+	if (it != mDates.cend())
+		return it->second;
+
+	// defaults & values which aren't ISO dates
+	long long packed;
+	if (packDate(get(key), packed))
+		return packed;
+
+	return defaultValue;
+}
+
 bool MetaDataList::wasChanged() const
 {
 	return mWasChanged;
@@ -71,6 +71,8 @@ public:
 	const std::string get(const std::string& key) const;
 	int getInt(const std::string& key) const;
 	float getFloat(const std::string& key) const;
+	// MD_DATE & MD_TIME values as the YYYYMMDDHHMMSS integer, which sorts like the ISO string, or defaultValue when it's not a date
+	long long getDate(const std::string& key, long long defaultValue = 0) const;
 
 	bool wasChanged() const;
 	void resetChangedFlag();
@@ -88,6 +90,7 @@ private:
 	SystemData*		mRelativeTo;
 
 	std::map<unsigned char, std::string> mMap;
+	std::map<unsigned char, long long> mDates; // ISO dates are kept packed, see getDate
 
 	unsigned char getId(const std::string& key) const;	
 	MetaDataType getType(unsigned char id) const;
@@ -1,10 +1,24 @@
 #include "ScraperCmdLine.h"
 
+#include "scrapers/GamesDBJSONScraperResources.h"
+#include "scrapers/ScraperCache.h"
+#include "scrapers/ScraperMediaProcessor.h"
+#include "scrapers/ThreadedScraper.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "FileData.h"
 #include "Log.h"
 #include "platform.h"
+#include "Settings.h"
 #include "SystemData.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <signal.h>
+#include <sstream>
+#include <unordered_set>
 #if defined(__linux__)
 #include <unistd.h>
 #elif defined(WIN32)
@@ -288,3 +302,181 @@ int run_scraper_cmdline()
 
 	return 0;
 }
+
+//==================================================================================
+// batch mode
+//==================================================================================
+
+// written by the signal handler
+static volatile sig_atomic_t batch_interrupted = 0;
+
+// Only sets the flag, which is async-signal-safe : the batch loop stops the scraper when it sees it
+void handle_batch_interrupt_signal(int /*p*/)
+{
+	batch_interrupted = 1;
+}
+
+static std::string getBatchKey(SystemData* system, FileData* game)
+{
+	return system->getName() + "\t" + game->getFullPath();
+}
+
+int run_scraper_batch(const std::string& systemNames, bool missingOnly)
+{
+	out << "EmulationStation batch scraper\n";
+	out << "==============================\n";
+
+	signal(SIGINT, handle_batch_interrupt_signal);
+	signal(SIGTERM, handle_batch_interrupt_signal);
+
+	//==================================================================================
+	//systems : all scrapable systems, or the ones listed (comma separated)
+	//==================================================================================
+	std::vector<SystemData*> systems;
+
+	if (systemNames.empty())
+	{
+		for (auto system : SystemData::sSystemVector)
+			if (system->isGameSystem() && !system->hasPlatformId(PlatformIds::PLATFORM_IGNORE))
+				systems.push_back(system);
+	}
+	else
+	{
+		for (auto name : Utils::String::split(systemNames, ','))
+		{
+			auto it = std::find_if(SystemData::sSystemVector.cbegin(), SystemData::sSystemVector.cend(), [name](SystemData* system) { return system->getName() == name; });
+			if (it == SystemData::sSystemVector.cend())
+			{
+				out << "System not found : " << name << "\n";
+				return 1;
+			}
+
+			systems.push_back(*it);
+		}
+	}
+
+	//==================================================================================
+	//journal : one line per game already scraped by a previous, interrupted run
+	//==================================================================================
+	std::string journalPath = getScrapersResouceDir() + "/scrape-batch.journal";
+	std::string reportPath = getScrapersResouceDir() + "/scrape-batch-report.txt";
+
+	Utils::FileSystem::createDirectory(getScrapersResouceDir());
+
+	std::unordered_set<std::string> journaled;
+
+	std::ifstream journalIn(journalPath);
+	for (std::string line; std::getline(journalIn, line); )
+		if (!line.empty())
+			journaled.insert(line);
+
+	journalIn.close();
+
+	std::queue<ScraperSearchParams> searches;
+	int skipped = 0;
+
+	for (auto system : systems)
+	{
+		for (auto game : system->getRootFolder()->getFilesRecursive(GAME))
+		{
+			if (journaled.find(getBatchKey(system, game)) != journaled.cend())
+			{
+				skipped++;
+				continue;
+			}
+
+			if (missingOnly && Utils::FileSystem::exists(game->metadata.get("image")))
+				continue;
+
+			ScraperSearchParams search;
+			search.game = game;
+			search.system = system;
+			search.overWriteMedias = !missingOnly;
+			searches.push(search);
+		}
+
+		out << "   " << system->getName() << " (" << system->getGameCount() << " games)\n";
+	}
+
+	if (skipped > 0)
+		out << "Resuming from " << journalPath << " : " << skipped << " games already scraped\n";
+
+	int total = (int)searches.size();
+	out << total << " games to scrape with " << Settings::getInstance()->getInt("ScraperThreads") << " search(es) & "
+		<< Settings::getInstance()->getInt("ScraperMaxDownloads") << " download(s) in parallel\n\n";
+
+	//==================================================================================
+	//scraping
+	//==================================================================================
+	std::mutex lock;
+	std::ofstream journal(journalPath, std::ios::app);
+	std::vector<std::string> failures;
+	int scraped = 0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	if (total > 0)
+	{
+		ThreadedScraper::start(nullptr, searches, [&](const ScraperSearchParams& params, const std::string& error)
+		{
+			std::unique_lock<std::mutex> guard(lock);
+
+			std::string name = "[" + params.system->getName() + "] " + params.game->getName();
+
+			if (!error.empty())
+			{
+				failures.push_back(name + " : " + error);
+				out << "   FAILED " << name << " : " << error << "\n";
+				return;
+			}
+
+			journal << getBatchKey(params.system, params.game) << "\n";
+			journal.flush();
+
+			scraped++;
+			out << "   " << (skipped + scraped) << "/" << (skipped + total) << " " << name << "\n";
+		});
+
+		while (ThreadedScraper::isRunning())
+		{
+			// The scraper thread finishes the games in progress, writes the gamelists & the journal, then stops
+			if (batch_interrupted)
+				ThreadedScraper::stop();
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		}
+	}
+
+	journal.close();
+
+	ScraperMediaProcessor::getInstance()->logStatistics();
+	ScraperMediaProcessor::deinit();
+
+	//==================================================================================
+	//report
+	//==================================================================================
+	double seconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0;
+	auto cache = ScraperCache::getInstance()->getStatistics();
+
+	std::stringstream report;
+	report << "Scraped : " << scraped << "/" << total << " games" << (batch_interrupted ? " (interrupted)" : "") << "\n";
+	report << "Skipped (journal) : " << skipped << "\n";
+	report << "Failed : " << failures.size() << "\n";
+	report << "Time : " << (int)seconds << " s, " << (seconds > 0 ? scraped * 60 / seconds : 0) << " games/min\n";
+	report << "Cache hits : " << cache.responseHits << "/" << (cache.responseHits + cache.responseMisses) << " responses, "
+		<< cache.mediaHits << "/" << (cache.mediaHits + cache.mediaMisses) << " medias\n";
+
+	for (auto failure : failures)
+		report << "   " << failure << "\n";
+
+	Utils::FileSystem::writeAllText(reportPath, report.str());
+
+	out << "\n" << report.str();
+	out << "Report written to " << reportPath << "\n";
+
+	// A complete run starts from scratch next time
+	if (!batch_interrupted && failures.empty())
+		Utils::FileSystem::removeFile(journalPath);
+
+	return failures.empty() && !batch_interrupted ? 0 : 1;
+}
@@ -2,6 +2,11 @@
 #ifndef ES_APP_SCRAPER_CMD_LINE_H
 #define ES_APP_SCRAPER_CMD_LINE_H
 
+#include <string>
+
 int run_scraper_cmdline();
 
+// Non interactive scraping, resumed from the journal of an interrupted run. systemNames is comma separated, empty for all systems
+int run_scraper_batch(const std::string& systemNames, bool missingOnly);
+
 #endif // ES_APP_SCRAPER_CMD_LINE_H
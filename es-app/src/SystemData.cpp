@@ -2,10 +2,14 @@
 
 #include "utils/FileSystemUtil.h"
 #include "CollectionSystemManager.h"
+#include "FileDataArena.h"
 #include "FileFilterIndex.h"
 #include "FileSorts.h"
+#include "GameCatalogue.h"
 #include "Gamelist.h"
 #include "Log.h"
+#include "MameNames.h"
+#include "MediaIndex.h"
 #include "platform.h"
 #include "Settings.h"
 #include "ThemeData.h"
@@ -16,21 +20,69 @@
 #include "GuiComponent.h"
 #include "Window.h"
 #include "views/ViewController.h"
+#include <mutex>
+#include <sys/stat.h>
+#include <unordered_set>
 
 using namespace Utils;
 
 std::vector<SystemData*> SystemData::sSystemVector;
 
+// Bios & device zips of arcade folders, remembered while the folder is not modified (systems are reloaded often)
+struct ArcadeAssets
+{
+	time_t modified;
+	std::unordered_set<std::string> files;
+};
+
+static std::mutex sArcadeAssetsLock;
+static std::unordered_map<std::string, ArcadeAssets> sArcadeAssets;
+
+static std::unordered_set<std::string> getArcadeAssets(const std::string& folderPath, const Utils::FileSystem::fileList& dirContent)
+{
+	struct stat info;
+	time_t modified = (stat(folderPath.c_str(), &info) == 0 ? info.st_mtime : 0);
+
+	{
+		std::unique_lock<std::mutex> lock(sArcadeAssetsLock);
+
+		auto it = sArcadeAssets.find(folderPath);
+		if (it != sArcadeAssets.cend() && modified != 0 && it->second.modified == modified)
+			return it->second.files;
+	}
+
+	ArcadeAssets assets;
+	assets.modified = modified;
+
+	for (auto& fileInfo : dirContent)
+	{
+		if (fileInfo.directory || Utils::String::toLower(Utils::FileSystem::getExtension(fileInfo.path)) != ".zip")
+			continue;
+
+		const std::string stem = Utils::FileSystem::getStem(fileInfo.path);
+		if (MameNames::getInstance()->isBios(stem) || MameNames::getInstance()->isDevice(stem))
+			assets.files.insert(fileInfo.path);
+	}
+
+	std::unique_lock<std::mutex> lock(sArcadeAssetsLock);
+	sArcadeAssets[folderPath] = assets;
+	return assets.files;
+}
+
 SystemData::SystemData(const std::string& name, const std::string& fullName, SystemEnvironmentData* envData, const std::string& themeFolder, bool CollectionSystem) :
 	mName(name), mFullName(fullName), mEnvData(envData), mThemeFolder(themeFolder), mIsCollectionSystem(CollectionSystem), mIsGameSystem(true)
 {
-	mGameCount = -1;
+	updateDisplayedGameCount();
 	mSortId = Settings::getInstance()->getInt(getName() + ".sort"),
 
 	mGridSizeOverride = Vector2f(0, 0);
 	mViewModeChanged = false;
 	mFilterIndex = nullptr;// new FileFilterIndex();
 
+	// the whole tree is built in the arena of the system, and freed with it
+	mArena = new FileDataArena();
+	FileDataArena::Scope arenaScope(mArena);
+
 	// if it's an actual system, initialize it, if not, just create the data structure
 	if (!CollectionSystem)
 	{
@@ -97,6 +149,7 @@ Vector2f SystemData::getGridSizeOverride()
 SystemData::~SystemData()
 {
 	delete mRootFolder;
+	delete mArena;
 
 	if (mFilterIndex != nullptr)
 		delete mFilterIndex;
@@ -137,6 +190,11 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 	
 	Utils::FileSystem::fileList dirContent = Utils::FileSystem::getDirInfo(folderPath);
 
+	// bios & device zips are filtered out before creating any FileData
+	std::unordered_set<std::string> arcadeAssets;
+	if (hasPlatformId(PlatformIds::ARCADE) || hasPlatformId(PlatformIds::NEOGEO))
+		arcadeAssets = getArcadeAssets(folderPath, dirContent);
+
 	for(Utils::FileSystem::fileList::const_iterator it = dirContent.cbegin(); it != dirContent.cend(); ++it)
 	{
 		auto fileInfo = *it;
@@ -156,17 +214,13 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 		isGame = false;
 		if (mEnvData->isValidExtension(extension)) //std::find(mEnvData->mSearchExtensions.cbegin(), mEnvData->mSearchExtensions.cend(), extension) != mEnvData->mSearchExtensions.cend())
 		{
-			if (fileMap.find(fileInfo.path) == fileMap.end())
+			// preventing new arcade assets to be added
+			if (fileMap.find(fileInfo.path) == fileMap.end() && (arcadeAssets.empty() || arcadeAssets.find(fileInfo.path) == arcadeAssets.cend()))
 			{
 				FileData* newGame = new FileData(GAME, fileInfo.path, this);
-
-				// preventing new arcade assets to be added
-				if (extension != ".zip" || !newGame->isArcadeAsset())
-				{
-					folder->addChild(newGame);
-					fileMap[fileInfo.path] = newGame;
-					isGame = true;
-				}
+				folder->addChild(newGame);
+				fileMap[fileInfo.path] = newGame;
+				isGame = true;
 			}
 		}
 		
@@ -415,6 +469,9 @@ bool SystemData::loadConfig(Window* window)
 	{
 		pThreadPool = new ThreadPool();
 
+		// the sorts of the other threads would read the catalogue columns while they grow
+		GameCatalogue::getInstance()->beginLoading();
+
 		systems = new SystemDataPtr[systemCount];
 		for (int i = 0; i < systemCount; i++)
 			systems[i] = nullptr;
@@ -476,6 +533,8 @@ bool SystemData::loadConfig(Window* window)
 		delete[] systems;
 		delete pThreadPool;
 
+		GameCatalogue::getInstance()->endLoading(sSystemVector);
+
 		if (window != NULL)
 			window->renderLoadingScreen(_("Favorites"), systemCount == 0 ? 0 : currentSystem / systemCount);
 
@@ -489,6 +548,19 @@ bool SystemData::loadConfig(Window* window)
 		CollectionSystemManager::get()->loadCollectionSystems();
 	}
 
+	size_t nodes = 0;
+	size_t blocks = 0;
+	size_t size = 0;
+
+	for (auto system : sSystemVector)
+	{
+		nodes += system->getArena()->getAllocationCount();
+		blocks += system->getArena()->getBlockCount();
+		size += system->getArena()->getSize();
+	}
+
+	LOG(LogInfo) << "FileDataArena : " << nodes << " nodes allocated in " << blocks << " blocks (" << (size / 1024) << " KB) for " << sSystemVector.size() << " systems";
+
 	if (SystemData::sSystemVector.size() > 0)
 	{
 		auto theme = SystemData::sSystemVector.at(0)->getTheme();
@@ -548,6 +620,10 @@ void SystemData::deleteSystems()
 {
 	bool saveOnExit = !Settings::getInstance()->getBool("IgnoreGamelist") && Settings::getInstance()->getBool("SaveGamelistsOnExit");
 
+	// No need to keep the path index & the catalogue up to date while deleting everything
+	FolderData::resetPathIndex();
+	GameCatalogue::getInstance()->clear();
+
 	for(unsigned int i = 0; i < sSystemVector.size(); i++)
 	{
 		SystemData* pData = sSystemVector.at(i);
@@ -558,6 +634,9 @@ void SystemData::deleteSystems()
 		delete pData;
 	}
 
+	// Media folders are listed again when systems are reloaded
+	MediaIndex::getInstance()->clear();
+
 	sSystemVector.clear();
 }
 
@@ -572,9 +651,10 @@ std::string SystemData::getConfigPath(bool forWrite)
 
 bool SystemData::isVisible()
 {
-   return (getDisplayedGameCount() > 0 || 
-           (UIModeController::getInstance()->isUIModeFull() && mIsCollectionSystem) ||
-           (mIsCollectionSystem && mName == "favorites"));
+   // the collections are tested first, counting their games would populate them
+   return ((UIModeController::getInstance()->isUIModeFull() && mIsCollectionSystem) ||
+           (mIsCollectionSystem && mName == "favorites") ||
+           getDisplayedGameCount() > 0);
 }
 
 SystemData* SystemData::getNext() const
@@ -655,9 +735,21 @@ bool SystemData::hasGamelist() const
 	return (Utils::FileSystem::exists(getGamelistPath(false)));
 }
 
-unsigned int SystemData::getGameCount() const
+unsigned int SystemData::getGameCount()
 {
-	return (unsigned int)mRootFolder->getFilesRecursive(GAME).size();
+	if (mTotalGameCount < 0)
+	{
+		if (!mIsCollectionSystem)
+			mTotalGameCount = GameCatalogue::getInstance()->countGames(this);
+		else
+		{
+			int count = 0;
+			mRootFolder->visitFiles(GAME, [&count](FileData*) { count++; return true; });
+			mTotalGameCount = count;
+		}
+	}
+
+	return (unsigned int)mTotalGameCount;
 }
 
 SystemData* SystemData::getRandomSystem()
@@ -693,27 +785,86 @@ SystemData* SystemData::getRandomSystem()
 
 FileData* SystemData::getRandomGame()
 {
-	std::vector<FileData*> list = mRootFolder->getFilesRecursive(GAME, true);
-	unsigned int total = (int)list.size();
+	unsigned int total = (unsigned int)getDisplayedGameCount();
 	int target = 0;
 	// get random number in range
 	if (total == 0)
 		return NULL;
 	target = (int)Math::round((std::rand() / (float)RAND_MAX) * (total - 1));
-	return list.at(target);
+
+	FileData* game = NULL;
+	mRootFolder->visitFiles(GAME, [&target, &game](FileData* file) { game = file; return target-- > 0; }, true);
+	return game;
+}
+
+// Unfiltered systems display all their games, which the catalogue counts without walking the tree
+bool SystemData::canCountFromCatalogue()
+{
+	if (mIsCollectionSystem)
+		return false;
+
+	FileFilterIndex* idx = getIndex(false);
+	return idx == nullptr || !idx->isFiltered();
 }
 
 int SystemData::getDisplayedGameCount() 
 {
 	if (mGameCount < 0)
-		mGameCount = mRootFolder->getFilesRecursive(GAME, true).size();
+	{
+		if (mIsCollectionSystem)
+			CollectionSystemManager::get()->populateCollection(this);
+
+		if (canCountFromCatalogue())
+			mGameCount = GameCatalogue::getInstance()->countGames(this);
+		else
+		{
+			int count = 0;
+			mRootFolder->visitFiles(GAME, [&count](FileData*) { count++; return true; }, true);
+			mGameCount = count;
+		}
+	}
 
 	return mGameCount;
 }
 
+int SystemData::getDisplayedVideoCount()
+{
+	if (mVideoCount < 0)
+	{
+		// without local art, a game has a video when its metadata says so
+		if (canCountFromCatalogue() && !Settings::getInstance()->getBool("LocalArt"))
+		{
+			mVideoCount = GameCatalogue::getInstance()->countGames(this, GameCatalogue::HAS_VIDEO);
+			return mVideoCount;
+		}
+
+		// sequential : with LocalArt, the MediaIndex lock serializes the lookups anyway
+		int count = 0;
+		mRootFolder->visitFiles(GAME, [&count](FileData* file) { if (!file->getVideoPath().empty()) count++; return true; }, true);
+		mVideoCount = count;
+	}
+
+	return mVideoCount;
+}
+
+int SystemData::getDisplayedImageCount()
+{
+	if (mImageCount < 0)
+	{
+		int count = 0;
+		mRootFolder->visitFiles(GAME, [&count](FileData* file) { if (!file->getImagePath().empty()) count++; return true; }, true);
+		mImageCount = count;
+	}
+
+	return mImageCount;
+}
+
 void SystemData::updateDisplayedGameCount()
 {
+	mTotalGameCount = -1;
 	mGameCount =-1;
+	mVideoCount = -1;
+	mImageCount = -1;
 }
 
 void SystemData::loadTheme()
@@ -16,6 +16,7 @@
 #include "Settings.h"
 
 class FileData;
+class FileDataArena;
 class FolderData;
 class ThemeData;
 class Window;
@@ -103,7 +104,9 @@ public:
 	SystemData(const std::string& name, const std::string& fullName, SystemEnvironmentData* envData, const std::string& themeFolder, bool CollectionSystem = false);
 	~SystemData();
 
-	inline FolderData* getRootFolder() const { return mRootFolder; };
+	inline FolderData* getRootFolder() const { return mRootFolder; };
+	// Where the nodes of the tree are allocated, while a FileDataArena::Scope is set on it
+	inline FileDataArena* getArena() const { return mArena; };
 	inline const std::string& getName() const { return mName; }
 	inline const std::string& getFullName() const { return mFullName; }
 	inline const std::string& getStartPath() const { return mEnvData->mStartPath; }
@@ -124,9 +127,13 @@ public:
 	bool hasGamelist() const;
 	std::string getThemePath() const;
 
-	unsigned int getGameCount() const;
+	unsigned int getGameCount();
 	
 	int getDisplayedGameCount();
+	// Displayed games having a video / an image, for the screensaver
+	int getDisplayedVideoCount();
+	int getDisplayedImageCount();
+	// Forgets all the counts above, they are computed again on next call
 	void updateDisplayedGameCount();
 
 	static void deleteSystems();
@@ -181,6 +188,8 @@ public:
 private:
 	static SystemData* loadSystem(pugi::xml_node system);
 
+	bool canCountFromCatalogue();
+
 	bool mIsCollectionSystem;
 	bool mIsGameSystem;
 	std::string mName;
@@ -202,7 +211,11 @@ private:
 	FileFilterIndex* mFilterIndex;
 
 	FolderData* mRootFolder;
+	FileDataArena* mArena;
+	int			mTotalGameCount;
 	int			mGameCount;
+	int			mVideoCount;
+	int			mImageCount;
 };
 
 #endif // ES_APP_SYSTEM_DATA_H
@@ -250,19 +250,11 @@ unsigned long SystemScreenSaver::countGameListNodes(const char *nodeName)
 		if (!(*it)->isGameSystem() || (*it)->isCollection())
 			continue;
 
-		FolderData* rootFileData = (*it)->getRootFolder();
-
-		std::vector<FileData*> allFiles = rootFileData->getFilesRecursive(GAME, true);
-		std::vector<FileData*>::const_iterator itf;  // declare an iterator to a vector of strings
-
-		for (itf=allFiles.cbegin() ; itf < allFiles.cend(); itf++) 
-		{
-			if ((strcmp(nodeName, "video") == 0 && (*itf)->getVideoPath() != "") ||
-				(strcmp(nodeName, "image") == 0 && (*itf)->getImagePath() != ""))
-			{
-				nodeCount++;
-			}
-		}
+		// The systems keep their counts until their games change
+		if (strcmp(nodeName, "video") == 0)
+			nodeCount += (*it)->getDisplayedVideoCount();
+		else if (strcmp(nodeName, "image") == 0)
+			nodeCount += (*it)->getDisplayedImageCount();
 	}
 	return nodeCount;
 }
@@ -296,42 +288,56 @@ std::string SystemScreenSaver::pickGameListNode(unsigned long index, const char
 		if (!(*it)->isGameSystem() || (*it)->isCollection())
 			continue;
 
-		FolderData* rootFileData = (*it)->getRootFolder();
+		bool video = (strcmp(nodeName, "video") == 0);
 
-		FileType type = GAME;
-		std::vector<FileData*> allFiles = rootFileData->getFilesRecursive(type, true);
-		std::vector<FileData*>::const_iterator itf;  // declare an iterator to a vector of strings
+		// Skip whole systems using their cached counts
+		unsigned long count = video ? (*it)->getDisplayedVideoCount() : (*it)->getDisplayedImageCount();
+		if (index >= count)
+		{
+			index -= count;
+			continue;
+		}
 
-		for(itf=allFiles.cbegin() ; itf < allFiles.cend(); itf++) 
+		FileData* game = nullptr;
+		(*it)->getRootFolder()->visitFiles(GAME, [&](FileData* file)
 		{
-			if ((strcmp(nodeName, "video") == 0 && (*itf)->getVideoPath() != "") ||
-				(strcmp(nodeName, "image") == 0 && (*itf)->getImagePath() != ""))
+			std::string media = video ? file->getVideoPath() : file->getImagePath();
+			if (media.empty())
+				return true;
+
+			if (index > 0)
 			{
-				if (index-- <= 0)
-				{
-					// We have it
-					if (strcmp(nodeName, "video") == 0)
-						path = (*itf)->getVideoPath();
-					else if (strcmp(nodeName, "image") == 0)
-						path = (*itf)->getImagePath();
+				index--;
+				return true;
+			}
+
+			// a missing file falls through to the next matching one
+			if (!Utils::FileSystem::exists(media))
+				return true;
+
+			// We have it
+			game = file;
+			path = media;
+			return false;
+		}, true);
 
-					if (!Utils::FileSystem::exists(path))
-						continue;
+		if (game == nullptr)
+		{
+			index = 0;
+			continue;
+		}
 
-					mSystemName = (*it)->getFullName();
-					mGameName = (*itf)->getName();
-					mCurrentGame = (*itf);
+		mSystemName = (*it)->getFullName();
+		mGameName = game->getName();
+		mCurrentGame = game;
 
 #ifdef _RPI_
-					if (Settings::getInstance()->getBool("ScreenSaverOmxPlayer"))
-						if (Settings::getInstance()->getString("ScreenSaverGameInfo") != "never" && strcmp(nodeName, "video") == 0)
-							writeSubtitle(mGameName.c_str(), mSystemName.c_str(), (Settings::getInstance()->getString("ScreenSaverGameInfo") == "always"));
+		if (Settings::getInstance()->getBool("ScreenSaverOmxPlayer"))
+			if (Settings::getInstance()->getString("ScreenSaverGameInfo") != "never" && video)
+				writeSubtitle(mGameName.c_str(), mSystemName.c_str(), (Settings::getInstance()->getString("ScreenSaverGameInfo") == "always"));
 #endif
 
-					return path;
-				}
-			}
-		}
+		return path;
 	}
 
 	return "";
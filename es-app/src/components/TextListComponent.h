@@ -30,6 +30,7 @@ protected:
 	using IList<TextListData, T>::getTransform;
 	using IList<TextListData, T>::mSize;
 	using IList<TextListData, T>::mCursor;
+	using IList<TextListData, T>::mScrollVelocity;
 	using IList<TextListData, T>::Entry;
 
 public:
@@ -59,6 +60,9 @@ public:
 
 	inline void setFont(const std::shared_ptr<Font>& font)
 	{
+		if(mFont == font)
+			return;
+
 		mFont = font;
 		for(auto it = mEntries.begin(); it != mEntries.end(); it++)
 			it->data.textCache.reset();
@@ -66,6 +70,9 @@ public:
 
 	inline void setUppercase(bool /*uppercase*/) 
 	{
+		if(mUppercase)
+			return;
+
 		mUppercase = true;
 		for(auto it = mEntries.begin(); it != mEntries.end(); it++)
 			it->data.textCache.reset();
@@ -85,6 +92,9 @@ protected:
 	virtual void onCursorChanged(const CursorState& state);
 
 private:
+	void buildEntryTextCache(typename IList<TextListData, T>::Entry& entry);
+	void prefetchTextCaches(int startEntry, int screenCount);
+
 	int mMarqueeOffset;
 	int mMarqueeOffset2;
 	int mMarqueeTime;
@@ -208,7 +218,7 @@ void TextListComponent<T>::render(const Transform4x4f& parentTrans)
 			color = mColors[entry.data.colorId];
 
 		if(!entry.data.textCache)
-			entry.data.textCache = std::unique_ptr<TextCache>(font->buildTextCache(mUppercase ? Utils::String::toUpper(entry.name) : entry.name, 0, 0, 0x000000FF));
+			buildEntryTextCache(entry);
 
 		entry.data.textCache->setColor(color);
 
@@ -259,11 +269,42 @@ void TextListComponent<T>::render(const Transform4x4f& parentTrans)
 
 	Renderer::popClipRect();
 
+	prefetchTextCaches(startEntry, screenCount);
+
 	listRenderTitleOverlay(trans);
 
 	GuiComponent::renderChildren(trans);
 }
 
+template <typename T>
+void TextListComponent<T>::buildEntryTextCache(typename IList<TextListData, T>::Entry& entry)
+{
+	entry.data.textCache = mFont->getTextCache(mUppercase ? Utils::String::toUpper(entry.name) : entry.name);
+}
+
+// build the text caches of the next page in the scroll direction so holding a direction never has to build a whole page in one frame
+template <typename T>
+void TextListComponent<T>::prefetchTextCaches(int startEntry, int screenCount)
+{
+	if(mScrollVelocity == 0 || screenCount <= 0)
+		return;
+
+	int from = (mScrollVelocity > 0) ? startEntry + screenCount : startEntry - screenCount;
+	int to = from + screenCount;
+
+	if(from < 0)
+		from = 0;
+	if(to > size())
+		to = size();
+
+	for(int i = from; i < to; i++)
+	{
+		typename IList<TextListData, T>::Entry& entry = mEntries.at((unsigned int)i);
+		if(!entry.data.textCache)
+			buildEntryTextCache(entry);
+	}
+}
+
 template <typename T>
 bool TextListComponent<T>::input(InputConfig* config, Input input)
 {
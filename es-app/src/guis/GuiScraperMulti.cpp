@@ -6,6 +6,7 @@
 #include "components/TextComponent.h"
 #include "guis/GuiMsgBox.h"
 #include "views/ViewController.h"
+#include "GameCatalogue.h"
 #include "Gamelist.h"
 #include "PowerSaver.h"
 #include "SystemData.h"
@@ -109,7 +110,7 @@ void GuiScraperMulti::doNextSearch()
 
 	// update subtitle
 	ss.str(""); // clear
-	ss << "GAME " << (mCurrentGame + 1) << " OF " << mTotalGames << " - " << Utils::String::toUpper(Utils::FileSystem::getFileName(mSearchQueue.front().game->getPath()));
+	ss << "GAME " << (mCurrentGame + 1) << " OF " << mTotalGames << " - " << Utils::String::toUpper(mSearchQueue.front().game->getFileName());
 	mSubtitle->setText(ss.str());
 
 	mSearchComp->search(mSearchQueue.front());
@@ -120,6 +121,7 @@ void GuiScraperMulti::acceptResult(const ScraperSearchResult& result)
 	ScraperSearchParams& search = mSearchQueue.front();
 
 	search.game->metadata.importScrappedMetadata(result.mdl);
+	GameCatalogue::getInstance()->update(search.game);
 	updateGamelist(search.system);
 
 	mSearchQueue.pop();
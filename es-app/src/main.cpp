@@ -3,6 +3,7 @@
 
 #include "guis/GuiDetectDevice.h"
 #include "guis/GuiMsgBox.h"
+#include "scrapers/ScraperMediaProcessor.h"
 #include "utils/FileSystemUtil.h"
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
@@ -10,6 +11,7 @@
 #include "InputManager.h"
 #include "Log.h"
 #include "MameNames.h"
+#include "MediaIndex.h"
 #include "platform.h"
 #include "PowerSaver.h"
 #include "ScraperCmdLine.h"
@@ -31,6 +33,9 @@
 #include "NetworkThread.h"
 
 bool scrape_cmdline = false;
+bool scrape_batch = false;
+bool scrape_batch_missing = false;
+std::string scrape_batch_systems;
 
 #include "components/VideoVlcComponent.h"
 
@@ -272,6 +277,31 @@ bool parseArgs(int argc, char* argv[])
 		{
 			scrape_cmdline = true;
 		}
+		else if (strcmp(argv[i], "--scrape-batch") == 0)
+		{
+			scrape_cmdline = true;
+			scrape_batch = true;
+
+			// optional list of systems
+			if (i < argc - 1 && argv[i + 1][0] != '-')
+				scrape_batch_systems = argv[++i];
+		}
+		else if (strcmp(argv[i], "--scrape-missing") == 0)
+		{
+			scrape_batch_missing = true;
+		}
+		else if (strcmp(argv[i], "--scrape-threads") == 0 && i < argc - 1)
+		{
+			Settings::getInstance()->setInt("ScraperThreads", atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--scrape-downloads") == 0 && i < argc - 1)
+		{
+			Settings::getInstance()->setInt("ScraperMaxDownloads", atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--scrape-replay") == 0)
+		{
+			Settings::getInstance()->setBool("ScraperCacheReplay", true);
+		}
 		else if (strcmp(argv[i], "--max-vram") == 0)
 		{
 			int maxVRAM = atoi(argv[i + 1]);
@@ -312,6 +342,11 @@ bool parseArgs(int argc, char* argv[])
 				"--no-splash			don't show the splash screen\n"
 				"--debug				more logging, show console on Windows\n"
 				"--scrape			scrape using command line interface\n"
+				"--scrape-batch [systems]	scrape without interaction all systems, or the comma separated ones, resuming an interrupted run\n"
+				"--scrape-missing		with --scrape-batch, only scrape games without image\n"
+				"--scrape-threads [count]	with --scrape-batch, number of searches running at the same time\n"
+				"--scrape-downloads [count]	with --scrape-batch, number of media downloads running at the same time\n"
+				"--scrape-replay			with --scrape-batch, only use the scraper cache, never the network\n"
 				"--windowed			not fullscreen, should be used with --resolution\n"
 				"--vsync [1/on or 0/off]		turn vsync on or off (default is on)\n"
 				"--max-vram [size]		Max VRAM to use in Mb before swapping. 0 for unlimited\n"
@@ -518,6 +553,9 @@ int main(int argc, char* argv[])
 	}
 
 	//run the command line scraper then quit
+	if (scrape_batch)
+		return run_scraper_batch(scrape_batch_systems, scrape_batch_missing);
+
 	if (scrape_cmdline)
 		return run_scraper_cmdline();
 
@@ -662,9 +700,13 @@ int main(int argc, char* argv[])
 
 	window.deinit(true);
 
+	ViewController::get()->stopPrefetch();
+
 	MameNames::deinit();
 	CollectionSystemManager::deinit();
 	SystemData::deleteSystems();
+	MediaIndex::deinit();
+	ScraperMediaProcessor::deinit();
 
 	// call this ONLY when linking with FreeImage as a static library
 #ifdef FREEIMAGE_LIB
@@ -1,6 +1,9 @@
 #include <chrono>
+#include <cstring>
+#include <ctime>
 #include <fstream>
 #include <memory>
+#include <sstream>
 #include <thread>
 
 #include "Log.h"
@@ -25,13 +28,19 @@ constexpr int POLL_TIME_MS = 500;
 constexpr int MAX_WAIT_ITER = MAX_WAIT_MS / POLL_TIME_MS;
 
 constexpr char SCRAPER_RESOURCES_DIR[] = "scrapers";
-constexpr char DEVELOPERS_JSON_FILE[] = "gamesdb_developers.json";
-constexpr char PUBLISHERS_JSON_FILE[] = "gamesdb_publishers.json";
-constexpr char GENRES_JSON_FILE[] = "gamesdb_genres.json";
+constexpr char DEVELOPERS_FILE[] = "gamesdb_developers.bin";
+constexpr char PUBLISHERS_FILE[] = "gamesdb_publishers.bin";
+constexpr char GENRES_FILE[] = "gamesdb_genres.bin";
 constexpr char DEVELOPERS_ENDPOINT[] = "/Developers";
 constexpr char PUBLISHERS_ENDPOINT[] = "/Publishers";
 constexpr char GENRES_ENDPOINT[] = "/Genres";
 
+constexpr int RESOURCES_MAX_AGE_DAYS = 30;
+
+// Binary resource : magic, version, download time, entry count, then entries as id, name length, name
+constexpr char RESOURCE_MAGIC[4] = { 'E', 'S', 'G', 'R' };
+constexpr unsigned int RESOURCE_VERSION = 1;
+
 std::string genFilePath(const std::string& file_name)
 {
 	return Utils::FileSystem::getGenericPath(getScrapersResouceDir() + "/" + file_name);
@@ -58,22 +67,29 @@ std::string TheGamesDBJSONRequestResources::getApiKey() const { return GamesDBAP
 
 void TheGamesDBJSONRequestResources::prepare()
 {
-	if (checkLoaded())
+	bool developersStale = false;
+	bool publishersStale = false;
+	bool genresStale = false;
+
+	if (!checkLoaded())
 	{
-		return;
+		if (loadResource(gamesdb_new_developers_map, "developers", DEVELOPERS_FILE, developersStale))
+			developersStale = true;
+		if (loadResource(gamesdb_new_publishers_map, "publishers", PUBLISHERS_FILE, publishersStale))
+			publishersStale = true;
+		if (loadResource(gamesdb_new_genres_map, "genres", GENRES_FILE, genresStale))
+			genresStale = true;
 	}
 
-	if (loadResource(gamesdb_new_developers_map, "developers", genFilePath(DEVELOPERS_JSON_FILE)) &&
-		!gamesdb_developers_resource_request)
+	if (developersStale && !gamesdb_developers_resource_request)
 	{
 		gamesdb_developers_resource_request = fetchResource(DEVELOPERS_ENDPOINT);
 	}
-	if (loadResource(gamesdb_new_publishers_map, "publishers", genFilePath(PUBLISHERS_JSON_FILE)) &&
-		!gamesdb_publishers_resource_request)
+	if (publishersStale && !gamesdb_publishers_resource_request)
 	{
 		gamesdb_publishers_resource_request = fetchResource(PUBLISHERS_ENDPOINT);
 	}
-	if (loadResource(gamesdb_new_genres_map, "genres", genFilePath(GENRES_JSON_FILE)) && !gamesdb_genres_resource_request)
+	if (genresStale && !gamesdb_genres_resource_request)
 	{
 		gamesdb_genres_resource_request = fetchResource(GENRES_ENDPOINT);
 	}
@@ -81,43 +97,45 @@ void TheGamesDBJSONRequestResources::prepare()
 
 void TheGamesDBJSONRequestResources::ensureResources()
 {
-
+	// Stale resources are still usable : they are refreshed when their download completes, without waiting for it
 	if (checkLoaded())
 	{
+		updateRequests();
 		return;
 	}
 
-
 	for (int i = 0; i < MAX_WAIT_ITER; ++i)
 	{
-		if (gamesdb_developers_resource_request &&
-			saveResource(gamesdb_developers_resource_request.get(), gamesdb_new_developers_map, "developers",
-				genFilePath(DEVELOPERS_JSON_FILE)))
-		{
-
-			gamesdb_developers_resource_request.reset(nullptr);
-		}
-		if (gamesdb_publishers_resource_request &&
-			saveResource(gamesdb_publishers_resource_request.get(), gamesdb_new_publishers_map, "publishers",
-				genFilePath(PUBLISHERS_JSON_FILE)))
-		{
-			gamesdb_publishers_resource_request.reset(nullptr);
-		}
-		if (gamesdb_genres_resource_request && saveResource(gamesdb_genres_resource_request.get(), gamesdb_new_genres_map,
-												   "genres", genFilePath(GENRES_JSON_FILE)))
-		{
-			gamesdb_genres_resource_request.reset(nullptr);
-		}
+		updateRequests();
 
 		if (!gamesdb_developers_resource_request && !gamesdb_publishers_resource_request && !gamesdb_genres_resource_request)
 		{
 			return;
 		}
-		std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIME_MS));
+		HttpReq::waitAny(POLL_TIME_MS);
 	}
 	LOG(LogError) << "Timed out while waiting for resources\n";
 }
 
+void TheGamesDBJSONRequestResources::updateRequests()
+{
+	if (gamesdb_developers_resource_request &&
+		saveResource(gamesdb_developers_resource_request.get(), gamesdb_new_developers_map, "developers", DEVELOPERS_FILE))
+	{
+		gamesdb_developers_resource_request.reset(nullptr);
+	}
+	if (gamesdb_publishers_resource_request &&
+		saveResource(gamesdb_publishers_resource_request.get(), gamesdb_new_publishers_map, "publishers", PUBLISHERS_FILE))
+	{
+		gamesdb_publishers_resource_request.reset(nullptr);
+	}
+	if (gamesdb_genres_resource_request &&
+		saveResource(gamesdb_genres_resource_request.get(), gamesdb_new_genres_map, "genres", GENRES_FILE))
+	{
+		gamesdb_genres_resource_request.reset(nullptr);
+	}
+}
+
 bool TheGamesDBJSONRequestResources::checkLoaded()
 {
 	return !gamesdb_new_genres_map.empty() && !gamesdb_new_developers_map.empty() && !gamesdb_new_publishers_map.empty();
@@ -142,12 +160,16 @@ bool TheGamesDBJSONRequestResources::saveResource(HttpReq* req, std::unordered_m
 		return true; // Request failed, resetting request.
 	}
 
+	std::unordered_map<int, std::string> downloaded;
+	if (parseResource(downloaded, resource_name, req->getContent()))
+	{
+		return true;
+	}
+
 	ensureScrapersResourcesDir();
+	writeBinaryResource(downloaded, genFilePath(file_name));
 
-	std::ofstream fout(file_name);
-	fout << req->getContent();
-	fout.close();
-	loadResource(resource, resource_name, file_name);
+	resource.swap(downloaded);
 	return true;
 }
 
@@ -160,25 +182,51 @@ std::unique_ptr<HttpReq> TheGamesDBJSONRequestResources::fetchResource(const std
 	return std::unique_ptr<HttpReq>(new HttpReq(path));
 }
 
-
-int TheGamesDBJSONRequestResources::loadResource(
-	std::unordered_map<int, std::string>& resource, const std::string& resource_name, const std::string& file_name)
+int TheGamesDBJSONRequestResources::loadResource(std::unordered_map<int, std::string>& resource,
+	const std::string& resource_name, const std::string& file_name, bool& stale)
 {
+	long long time = 0;
+	if (readBinaryResource(resource, genFilePath(file_name), time) == 0)
+	{
+		stale = ((long long)std::time(nullptr) - time) > (long long)RESOURCES_MAX_AGE_DAYS * 86400;
+		return 0;
+	}
 
+	// Resources downloaded by older versions are converted once
+	std::string json_file = genFilePath("gamesdb_" + resource_name + ".json");
 
-	std::ifstream fin(file_name);
+	std::ifstream fin(json_file);
 	if (!fin.good())
 	{
 		return 1;
 	}
 	std::stringstream buffer;
 	buffer << fin.rdbuf();
+	fin.close();
+
+	if (parseResource(resource, resource_name, buffer.str()))
+	{
+		return 1;
+	}
+
+	if (writeBinaryResource(resource, genFilePath(file_name)))
+	{
+		Utils::FileSystem::removeFile(json_file);
+	}
+
+	stale = true; // its age is unknown
+	return 0;
+}
+
+int TheGamesDBJSONRequestResources::parseResource(
+	std::unordered_map<int, std::string>& resource, const std::string& resource_name, const std::string& json)
+{
 	Document doc;
-	doc.Parse(buffer.str().c_str());
+	doc.Parse(json.c_str());
 
 	if (doc.HasParseError())
 	{
-		std::string err = std::string("TheGamesDBJSONRequest - Error parsing JSON for resource file ") + file_name +
+		std::string err = std::string("TheGamesDBJSONRequest - Error parsing JSON for resource ") + resource_name +
 						  ":\n\t" + GetParseError_En(doc.GetParseError());
 		LOG(LogError) << err;
 		return 1;
@@ -193,6 +241,8 @@ int TheGamesDBJSONRequestResources::loadResource(
 	}
 	auto& data = doc["data"][resource_name.c_str()];
 
+	resource.reserve(data.MemberCount());
+
 	for (Value::ConstMemberIterator itr = data.MemberBegin(); itr != data.MemberEnd(); ++itr)
 	{
 		auto& entry = itr->value;
@@ -201,7 +251,103 @@ int TheGamesDBJSONRequestResources::loadResource(
 		{
 			continue;
 		}
-		resource[entry["id"].GetInt()] = entry["name"].GetString();
+		resource[entry["id"].GetInt()] = std::string(entry["name"].GetString(), entry["name"].GetStringLength());
 	}
 	return resource.empty();
 }
+
+int TheGamesDBJSONRequestResources::readBinaryResource(
+	std::unordered_map<int, std::string>& resource, const std::string& file_name, long long& time)
+{
+	std::ifstream fin(file_name, std::ios::binary);
+	if (!fin.good())
+	{
+		return 1;
+	}
+
+	std::string data((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+	fin.close();
+
+	const char* cursor = data.c_str();
+	const char* end = cursor + data.size();
+
+	auto read = [&cursor, end](void* value, size_t size)
+	{
+		if ((size_t)(end - cursor) < size)
+			return false;
+
+		memcpy(value, cursor, size);
+		cursor += size;
+		return true;
+	};
+
+	char magic[sizeof(RESOURCE_MAGIC)];
+	unsigned int version = 0;
+	unsigned int count = 0;
+
+	if (!read(magic, sizeof(magic)) || memcmp(magic, RESOURCE_MAGIC, sizeof(magic)) != 0 ||
+		!read(&version, sizeof(version)) || version != RESOURCE_VERSION || !read(&time, sizeof(time)) ||
+		!read(&count, sizeof(count)))
+	{
+		LOG(LogWarning) << "TheGamesDBJSONRequest - Invalid resource file " << file_name;
+		return 1;
+	}
+
+	resource.clear();
+	resource.reserve(count);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		int id;
+		unsigned int length;
+
+		if (!read(&id, sizeof(id)) || !read(&length, sizeof(length)) || (size_t)(end - cursor) < length)
+		{
+			LOG(LogWarning) << "TheGamesDBJSONRequest - Truncated resource file " << file_name;
+			resource.clear();
+			return 1;
+		}
+
+		resource[id] = std::string(cursor, length);
+		cursor += length;
+	}
+
+	return resource.empty();
+}
+
+bool TheGamesDBJSONRequestResources::writeBinaryResource(
+	const std::unordered_map<int, std::string>& resource, const std::string& file_name)
+{
+	std::ofstream fout(file_name + ".tmp", std::ios::binary);
+	if (!fout.good())
+	{
+		return false;
+	}
+
+	long long time = (long long)std::time(nullptr);
+	unsigned int count = (unsigned int)resource.size();
+
+	fout.write(RESOURCE_MAGIC, sizeof(RESOURCE_MAGIC));
+	fout.write((const char*)&RESOURCE_VERSION, sizeof(RESOURCE_VERSION));
+	fout.write((const char*)&time, sizeof(time));
+	fout.write((const char*)&count, sizeof(count));
+
+	for (auto& entry : resource)
+	{
+		int id = entry.first;
+		unsigned int length = (unsigned int)entry.second.size();
+
+		fout.write((const char*)&id, sizeof(id));
+		fout.write((const char*)&length, sizeof(length));
+		fout.write(entry.second.c_str(), length);
+	}
+
+	fout.close();
+	if (fout.fail())
+	{
+		Utils::FileSystem::removeFile(file_name + ".tmp");
+		return false;
+	}
+
+	return Utils::FileSystem::renameFile(file_name + ".tmp", file_name);
+}
@@ -10,6 +10,8 @@
 #include "HttpReq.h"
 
 
+// The developers, publishers & genres maps are kept in a compact binary form (gamesdb_*.bin), read in one block at startup.
+// They are downloaded again in the background when older than RESOURCES_MAX_AGE_DAYS.
 struct TheGamesDBJSONRequestResources
 {
 	TheGamesDBJSONRequestResources() = default;
@@ -24,13 +26,20 @@ struct TheGamesDBJSONRequestResources
 
   private:
 	bool checkLoaded();
+	void updateRequests();
 
 	bool saveResource(HttpReq* req, std::unordered_map<int, std::string>& resource, const std::string& resource_name,
 		const std::string& file_name);
 	std::unique_ptr<HttpReq> fetchResource(const std::string& endpoint);
 
-	int loadResource(
-		std::unordered_map<int, std::string>& resource, const std::string& resource_name, const std::string& file_name);
+	// Returns 0 if the resource is loaded, and sets stale if it should be downloaded again
+	int loadResource(std::unordered_map<int, std::string>& resource, const std::string& resource_name,
+		const std::string& file_name, bool& stale);
+
+	static int parseResource(
+		std::unordered_map<int, std::string>& resource, const std::string& resource_name, const std::string& json);
+	static int readBinaryResource(std::unordered_map<int, std::string>& resource, const std::string& file_name, long long& time);
+	static bool writeBinaryResource(const std::unordered_map<int, std::string>& resource, const std::string& file_name);
 
 	std::unique_ptr<HttpReq> gamesdb_developers_resource_request;
 	std::unique_ptr<HttpReq> gamesdb_publishers_resource_request;
@@ -0,0 +1,425 @@
+#include "scrapers/RomHashCache.h"
+
+#include "scrapers/GamesDBJSONScraperResources.h"
+#include "scrapers/md5.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/ThreadPool.h"
+#include "Log.h"
+#include <algorithm>
+#include <fstream>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define HASH_BUFFER_SIZE (1024 * 1024)
+
+static std::string toHex(const unsigned char* data, size_t length)
+{
+	static const char digits[] = "0123456789abcdef";
+
+	std::string ret;
+	ret.reserve(length * 2);
+
+	for (size_t i = 0; i < length; i++)
+	{
+		ret += digits[data[i] >> 4];
+		ret += digits[data[i] & 0x0F];
+	}
+
+	return ret;
+}
+
+class CRC32Hash
+{
+public:
+	CRC32Hash() : mCrc(0xFFFFFFFF) { }
+
+	void update(const unsigned char* data, size_t length)
+	{
+		const Table& table = getTable();
+		for (size_t i = 0; i < length; i++)
+			mCrc = table.values[(mCrc ^ data[i]) & 0xFF] ^ (mCrc >> 8);
+	}
+
+	std::string hexdigest() const
+	{
+		uint32_t crc = mCrc ^ 0xFFFFFFFF;
+		unsigned char bytes[4] = { (unsigned char)(crc >> 24), (unsigned char)(crc >> 16), (unsigned char)(crc >> 8), (unsigned char)crc };
+		return toHex(bytes, 4);
+	}
+
+private:
+	struct Table
+	{
+		uint32_t values[256];
+	};
+
+	// Built once, thread-safe : files are hashed on several threads
+	static const Table& getTable()
+	{
+		static const Table table = []
+		{
+			Table ret;
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+
+				ret.values[i] = c;
+			}
+
+			return ret;
+		}();
+
+		return table;
+	}
+
+	uint32_t mCrc;
+};
+
+class SHA1Hash
+{
+public:
+	SHA1Hash() : mLength(0), mBufferSize(0)
+	{
+		mState[0] = 0x67452301;
+		mState[1] = 0xEFCDAB89;
+		mState[2] = 0x98BADCFE;
+		mState[3] = 0x10325476;
+		mState[4] = 0xC3D2E1F0;
+	}
+
+	void update(const unsigned char* data, size_t length)
+	{
+		mLength += length;
+
+		while (length > 0)
+		{
+			size_t count = std::min(length, (size_t)64 - mBufferSize);
+			memcpy(mBuffer + mBufferSize, data, count);
+
+			mBufferSize += count;
+			data += count;
+			length -= count;
+
+			if (mBufferSize == 64)
+			{
+				transform(mBuffer);
+				mBufferSize = 0;
+			}
+		}
+	}
+
+	std::string hexdigest()
+	{
+		uint64_t bitLength = mLength * 8;
+
+		unsigned char padding = 0x80;
+		update(&padding, 1);
+
+		padding = 0;
+		while (mBufferSize != 56)
+			update(&padding, 1);
+
+		unsigned char length[8];
+		for (int i = 0; i < 8; i++)
+			length[i] = (unsigned char)(bitLength >> (56 - i * 8));
+
+		update(length, 8);
+
+		unsigned char digest[20];
+		for (int i = 0; i < 20; i++)
+			digest[i] = (unsigned char)(mState[i / 4] >> (24 - (i % 4) * 8));
+
+		return toHex(digest, 20);
+	}
+
+private:
+	static uint32_t rol(uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); }
+
+	void transform(const unsigned char* block)
+	{
+		uint32_t w[80];
+
+		for (int i = 0; i < 16; i++)
+			w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) | ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+
+		for (int i = 16; i < 80; i++)
+			w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+		uint32_t a = mState[0], b = mState[1], c = mState[2], d = mState[3], e = mState[4];
+
+		for (int i = 0; i < 80; i++)
+		{
+			uint32_t f, k;
+
+			if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+			else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+			else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+			else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+
+			uint32_t temp = rol(a, 5) + f + e + k + w[i];
+			e = d;
+			d = c;
+			c = rol(b, 30);
+			b = a;
+			a = temp;
+		}
+
+		mState[0] += a;
+		mState[1] += b;
+		mState[2] += c;
+		mState[3] += d;
+		mState[4] += e;
+	}
+
+	uint32_t mState[5];
+	uint64_t mLength;
+	unsigned char mBuffer[64];
+	size_t mBufferSize;
+};
+
+RomHashCache* RomHashCache::sInstance = nullptr;
+
+RomHashCache* RomHashCache::getInstance()
+{
+	static std::mutex instanceLock;
+	std::unique_lock<std::mutex> lock(instanceLock);
+
+	if (sInstance == nullptr)
+		sInstance = new RomHashCache();
+
+	return sInstance;
+}
+
+RomHashCache::RomHashCache()
+{
+	mCacheFile = getScrapersResouceDir() + "/romhashes.cache";
+	load();
+}
+
+bool RomHashCache::getFileInfo(const std::string& path, long long& size, long long& modified)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+		return false;
+
+	size = (long long)info.st_size;
+	modified = (long long)info.st_mtime;
+	return true;
+}
+
+bool RomHashCache::findEntry(const std::string& path, long long size, long long modified, RomHashes& hashes)
+{
+	auto it = mEntries.find(path);
+	if (it == mEntries.cend() || it->second.size != size || it->second.modified != modified)
+		return false;
+
+	hashes = it->second.hashes;
+	return true;
+}
+
+bool RomHashCache::getHashes(const std::string& path, RomHashes& hashes, long long maxSize)
+{
+	long long size, modified;
+	if (!getFileInfo(path, size, modified))
+		return false;
+
+	if (maxSize > 0 && size > maxSize)
+		return false;
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	// Another thread is hashing it : wait for its result
+	mHashed.wait(lock, [this, &path] { return mInProgress.find(path) == mInProgress.cend(); });
+
+	if (findEntry(path, size, modified, hashes))
+		return true;
+
+	mInProgress.insert(path);
+	lock.unlock();
+
+	Entry entry;
+	entry.size = size;
+	entry.modified = modified;
+
+	bool ret = hashFile(path, entry.hashes);
+
+	lock.lock();
+	mInProgress.erase(path);
+
+	if (ret)
+	{
+		mEntries[path] = entry;
+		append(path, entry);
+		hashes = entry.hashes;
+	}
+
+	mHashed.notify_all();
+	return ret;
+}
+
+void RomHashCache::computeHashes(const std::vector<std::string>& paths, long long maxSize, const std::atomic<bool>& cancel)
+{
+	if (std::thread::hardware_concurrency() <= 1)
+	{
+		for (auto path : paths)
+		{
+			if (cancel)
+				break;
+
+			RomHashes hashes;
+			getHashes(path, hashes, maxSize);
+		}
+
+		return;
+	}
+
+	Utils::ThreadPool pool;
+
+	for (auto path : paths)
+	{
+		pool.queueWorkItem([this, path, maxSize, &cancel]
+		{
+			if (cancel)
+				return;
+
+			RomHashes hashes;
+			getHashes(path, hashes, maxSize);
+		});
+	}
+
+	pool.wait([] { }, 50);
+}
+
+// Reads the file once & feeds the three hashes
+bool RomHashCache::hashFile(const std::string& path, RomHashes& hashes)
+{
+	std::vector<unsigned char> buffer(HASH_BUFFER_SIZE);
+
+	CRC32Hash crc;
+	MD5 md5;
+	SHA1Hash sha1;
+
+#if defined(_WIN32)
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	size_t size;
+	while ((size = fread(buffer.data(), 1, HASH_BUFFER_SIZE, file)) > 0)
+	{
+		crc.update(buffer.data(), size);
+		md5.update(buffer.data(), (MD5::size_type)size);
+		sha1.update(buffer.data(), size);
+	}
+
+	bool error = ferror(file) != 0;
+	fclose(file);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	ssize_t size;
+	while ((size = read(fd, buffer.data(), HASH_BUFFER_SIZE)) > 0)
+	{
+		crc.update(buffer.data(), size);
+		md5.update(buffer.data(), (MD5::size_type)size);
+		sha1.update(buffer.data(), size);
+	}
+
+	bool error = size < 0;
+
+#if defined(POSIX_FADV_DONTNEED)
+	// The rom won't be read again soon, don't let it push more useful data out of the page cache
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+
+	close(fd);
+#endif
+
+	if (error)
+		return false;
+
+	md5.finalize();
+
+	hashes.crc32 = crc.hexdigest();
+	hashes.md5 = md5.hexdigest();
+	hashes.sha1 = sha1.hexdigest();
+	return true;
+}
+
+// One line per file : size, date, crc32, md5, sha1, path. Later lines replace earlier ones
+void RomHashCache::load()
+{
+	std::ifstream file(mCacheFile);
+	if (!file.is_open())
+		return;
+
+	int lines = 0;
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::vector<std::string> fields;
+
+		size_t start = 0;
+		for (int i = 0; i < 5; i++)
+		{
+			size_t tab = line.find('\t', start);
+			if (tab == std::string::npos)
+				break;
+
+			fields.push_back(line.substr(start, tab - start));
+			start = tab + 1;
+		}
+
+		if (fields.size() != 5 || start >= line.size())
+			continue;
+
+		Entry entry;
+		entry.size = atoll(fields[0].c_str());
+		entry.modified = atoll(fields[1].c_str());
+		entry.hashes.crc32 = fields[2];
+		entry.hashes.md5 = fields[3];
+		entry.hashes.sha1 = fields[4];
+
+		mEntries[line.substr(start)] = entry;
+		lines++;
+	}
+
+	file.close();
+
+	// Too many outdated lines : rewrite the file
+	if (lines > 1024 && lines > (int)mEntries.size() * 2)
+	{
+		std::ofstream out(mCacheFile, std::ios::out | std::ios::trunc);
+		for (auto it = mEntries.cbegin(); it != mEntries.cend(); it++)
+			out << it->second.size << "\t" << it->second.modified << "\t" << it->second.hashes.crc32 << "\t" << it->second.hashes.md5 << "\t" << it->second.hashes.sha1 << "\t" << it->first << "\n";
+	}
+
+	LOG(LogDebug) << "RomHashCache : " << mEntries.size() << " hashes loaded";
+}
+
+// mLock must be locked
+void RomHashCache::append(const std::string& path, const Entry& entry)
+{
+	if (!Utils::FileSystem::exists(Utils::FileSystem::getParent(mCacheFile)))
+		Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(mCacheFile));
+
+	std::ofstream out(mCacheFile, std::ios::out | std::ios::app);
+	if (out.is_open())
+		out << entry.size << "\t" << entry.modified << "\t" << entry.hashes.crc32 << "\t" << entry.hashes.md5 << "\t" << entry.hashes.sha1 << "\t" << path << "\n";
+}
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef ES_APP_SCRAPERS_ROM_HASH_CACHE_H
+#define ES_APP_SCRAPERS_ROM_HASH_CACHE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct RomHashes
+{
+	std::string crc32;
+	std::string md5;
+	std::string sha1;
+};
+
+// Hashes rom files for the scrapers. CRC32, MD5 & SHA1 are computed in a single read of the file,
+// and remembered in <home>/.emulationstation/scrapers/romhashes.cache as long as the file size & date don't change.
+class RomHashCache
+{
+public:
+	static RomHashCache* getInstance();
+
+	// Returns false if the file can't be read, or is bigger than maxSize (0 = no limit)
+	bool getHashes(const std::string& path, RomHashes& hashes, long long maxSize = 0);
+
+	// Hashes the files which are not in the cache yet, in parallel. Stops early when cancel becomes true
+	void computeHashes(const std::vector<std::string>& paths, long long maxSize, const std::atomic<bool>& cancel);
+
+private:
+	RomHashCache();
+
+	struct Entry
+	{
+		long long size;
+		long long modified;
+		RomHashes hashes;
+	};
+
+	bool getFileInfo(const std::string& path, long long& size, long long& modified);
+	bool findEntry(const std::string& path, long long size, long long modified, RomHashes& hashes);
+
+	void load();
+	void append(const std::string& path, const Entry& entry);
+
+	static bool hashFile(const std::string& path, RomHashes& hashes);
+
+	static RomHashCache* sInstance;
+
+	std::mutex mLock;
+	std::condition_variable mHashed;
+
+	std::string mCacheFile;
+	std::unordered_map<std::string, Entry> mEntries;
+	std::unordered_set<std::string> mInProgress;
+};
+
+#endif // ES_APP_SCRAPERS_ROM_HASH_CACHE_H
@@ -3,6 +3,9 @@
 #include "FileData.h"
 #include "GamesDBJSONScraper.h"
 #include "ScreenScraper.h"
+#include "RomHashCache.h"
+#include "ScraperCache.h"
+#include "ScraperMediaProcessor.h"
 #include "Log.h"
 #include "Settings.h"
 #include "SystemData.h"
@@ -36,6 +39,19 @@ std::unique_ptr<ScraperSearchHandle> startScraperSearch(const ScraperSearchParam
 	return handle;
 }
 
+void prepareScraperSearches(const std::vector<ScraperSearchParams>& searches, const std::atomic<bool>& cancel)
+{
+	if (Settings::getInstance()->getString("Scraper") != "ScreenScraper")
+		return;
+
+	std::vector<std::string> paths;
+	for (auto& search : searches)
+		if (search.nameOverride.empty())
+			paths.push_back(search.game->getFullPath());
+
+	RomHashCache::getInstance()->computeHashes(paths, SCREENSCRAPER_MAX_HASHED_ROM_SIZE, cancel);
+}
+
 std::vector<std::string> getScraperList()
 {
 	std::vector<std::string> list;
@@ -113,18 +129,39 @@ ScraperHttpRequest::ScraperHttpRequest(std::vector<ScraperSearchResult>& results
 	: ScraperRequest(resultsWrite)
 {
 	setStatus(ASYNC_IN_PROGRESS);
-	mReq = std::unique_ptr<HttpReq>(new HttpReq(url));
 	mRetryCount = 0;
+	mCached = false;
+
+	if (ScraperCache::isEnabled() && ScraperCache::getInstance()->getResponse(url, mCachedContent))
+		mCached = true;
+	else if (ScraperCache::isReplayMode())
+		setError("Request not found in the scraper cache");
+	else
+		mReq = std::unique_ptr<HttpReq>(new HttpReq(url));
 }
 
 void ScraperHttpRequest::update()
 {
+	if (mStatus != ASYNC_IN_PROGRESS)
+		return;
+
+	if (mCached)
+	{
+		setStatus(ASYNC_DONE);
+		process(mCachedContent, mResults);
+		return;
+	}
+
 	HttpReq::Status status = mReq->status();
 	if(status == HttpReq::REQ_SUCCESS)
 	{
 		setStatus(ASYNC_DONE); // if process() has an error, status will be changed to ASYNC_ERROR
 
-		if (!process(mReq, mResults))
+		bool processed = process(mReq->getContent(), mResults);
+		if (processed && mStatus == ASYNC_DONE && ScraperCache::isEnabled())
+			ScraperCache::getInstance()->putResponse(mReq->getUrl(), mReq->getContent());
+
+		if (!processed)
 		{
 			mRetryCount++;
 			if (mRetryCount > 4)
@@ -353,13 +390,20 @@ std::unique_ptr<ImageDownloadHandle> downloadImageAsync(const std::string& url,
 }
 
 ImageDownloadHandle::ImageDownloadHandle(const std::string& url, const std::string& path, int maxWidth, int maxHeight) : 
-	mSavePath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight), mReq(new HttpReq(url))
+	mUrl(url), mSavePath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight)
 {
+	if (ScraperCache::isEnabled() && ScraperCache::getInstance()->getMedia(url, path))
+		return;
+
+	if (ScraperCache::isReplayMode())
+		setError("Media not found in the scraper cache");
+	else
+		mReq = std::unique_ptr<HttpReq>(new HttpReq(url, path, true));
 }
 
 int ImageDownloadHandle::getPercent()
 {
-	if (mReq->status() == HttpReq::REQ_IN_PROGRESS)
+	if (mReq != nullptr && mReq->status() == HttpReq::REQ_IN_PROGRESS)
 		return mReq->getPercent();
 
 	return -1;
@@ -367,9 +411,34 @@ int ImageDownloadHandle::getPercent()
 
 void ImageDownloadHandle::update()
 {
+	if (mStatus != ASYNC_IN_PROGRESS)
+		return;
+
+	// Waiting for the media processor
+	if (mResizeJob != nullptr)
+	{
+		if (mResizeJob->isDone())
+			finishResize();
+
+		return;
+	}
+
+	// Served from the cache, the original file is already saved
+	if (mReq == nullptr)
+	{
+		resizeMedia();
+		return;
+	}
+
 	if(mReq->status() == HttpReq::REQ_IN_PROGRESS)
 		return;
 
+	if (mReq->status() == HttpReq::REQ_INVALID_RESPONSE)
+	{
+		setError("Failed to save media : The server response is invalid");
+		return;
+	}
+
 	if(mReq->status() != HttpReq::REQ_SUCCESS)
 	{
 		std::stringstream ss;
@@ -378,27 +447,45 @@ void ImageDownloadHandle::update()
 		return;
 	}
 
-	if (mStatus == ASYNC_IN_PROGRESS)
+	int ret = mReq->saveContent(mSavePath, true);
+	if (ret == 2)
 	{
-		int ret = mReq->saveContent(mSavePath, true);
-		if (ret == 2)
-		{
-			setError("Failed to save media : The server response is invalid");
-			return;
-		}
-		else if (ret == 1)
-		{
-			setError("Failed to save image on disk. Disk full?");
-			return;
-		}
-	
-		// It's an image ?
-		std::string ext = Utils::String::toLower(Utils::FileSystem::getExtension(mSavePath));
-		if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" || ext == ".gif")
-			resizeImage(mSavePath, mMaxWidth, mMaxHeight);
+		setError("Failed to save media : The server response is invalid");
+		return;
+	}
+	else if (ret == 1)
+	{
+		setError("Failed to save image on disk. Disk full?");
+		return;
 	}
 
-	setStatus(ASYNC_DONE);
+	// The original media is cached, so that changing the resize settings doesn't need to download it again
+	if (ScraperCache::isEnabled())
+		ScraperCache::getInstance()->putMedia(mUrl, mSavePath);
+
+	resizeMedia();
+}
+
+void ImageDownloadHandle::resizeMedia()
+{
+	// It's an image ?
+	std::string ext = Utils::String::toLower(Utils::FileSystem::getExtension(mSavePath));
+	if ((mMaxWidth != 0 || mMaxHeight != 0) && (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" || ext == ".gif"))
+	{
+		mResizeJob = ScraperMediaProcessor::getInstance()->resizeImage(mSavePath, mMaxWidth, mMaxHeight);
+		if (mResizeJob->isDone())
+			finishResize();
+	}
+	else
+		setStatus(ASYNC_DONE);
+}
+
+void ImageDownloadHandle::finishResize()
+{
+	if (mResizeJob->succeeded())
+		setStatus(ASYNC_DONE);
+	else
+		setError("Error saving resized image. Out of memory? Disk full?");
 }
 
 //you can pass 0 for width or height to keep aspect ratio
@@ -441,6 +528,13 @@ bool resizeImage(const std::string& path, int maxWidth, int maxHeight)
 		maxHeight = (int)((maxWidth / width) * height);
 	}
 
+	// already at the right size, no need to encode it again
+	if ((int)width == maxWidth && (int)height == maxHeight)
+	{
+		FreeImage_Unload(image);
+		return true;
+	}
+
 	FIBITMAP* imageRescaled = FreeImage_Rescale(image, maxWidth, maxHeight, FILTER_BILINEAR);
 	FreeImage_Unload(image);
 
@@ -450,9 +544,13 @@ bool resizeImage(const std::string& path, int maxWidth, int maxHeight)
 		return false;
 	}
 
-	bool saved = (FreeImage_Save(format, imageRescaled, path.c_str()) != 0);
+	// written aside then renamed : the file can be a hard link to the scraper cache, which must keep the original
+	bool saved = (FreeImage_Save(format, imageRescaled, (path + ".tmp").c_str()) != 0) && Utils::FileSystem::renameFile(path + ".tmp", path);
 	FreeImage_Unload(imageRescaled);
 
+	if (!saved)
+		Utils::FileSystem::removeFile(path + ".tmp");
+
 	if(!saved)
 		LOG(LogError) << "Failed to save resized image!";
 
@@ -462,7 +560,7 @@ bool resizeImage(const std::string& path, int maxWidth, int maxHeight)
 std::string getSaveAsPath(const ScraperSearchParams& params, const std::string& suffix, const std::string& extension)
 {
 	const std::string subdirectory = params.system->getName();
-	const std::string name = Utils::FileSystem::getStem(params.game->getPath()) + "-" + suffix;
+	const std::string name = params.game->getStem() + "-" + suffix;
 
 	std::string subFolder = "images";
 	if (suffix == "video")
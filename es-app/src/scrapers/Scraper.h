@@ -4,7 +4,9 @@
 
 #include "AsyncHandle.h"
 #include "HttpReq.h"
+#include "scrapers/ScraperMediaProcessor.h"
 #include "MetaData.h"
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <queue>
@@ -95,11 +97,15 @@ public:
 	virtual void update() override;
 
 protected:
-	virtual bool process(const std::unique_ptr<HttpReq>& req, std::vector<ScraperSearchResult>& results) = 0;
+	virtual bool process(const std::string& content, std::vector<ScraperSearchResult>& results) = 0;
 
 private:
 	std::unique_ptr<HttpReq> mReq;
 	int	mRetryCount;
+
+	// Response read from the ScraperCache, mReq is null
+	bool mCached;
+	std::string mCachedContent;
 };
 
 // a request to get a list of results
@@ -121,6 +127,9 @@ protected:
 // will use the current scraper settings to pick the result source
 std::unique_ptr<ScraperSearchHandle> startScraperSearch(const ScraperSearchParams& params);
 
+// prepares what the current scraper needs before searching (rom hashes...), can be called ahead from another thread
+void prepareScraperSearches(const std::vector<ScraperSearchParams>& searches, const std::atomic<bool>& cancel);
+
 // returns a list of valid scraper names
 std::vector<std::string> getScraperList();
 
@@ -199,7 +208,12 @@ public:
 	virtual int getPercent();
 
 private:
-	std::unique_ptr<HttpReq> mReq;
+	void resizeMedia();
+	void finishResize();
+
+	std::unique_ptr<HttpReq> mReq; // null when the media is served from the ScraperCache
+	std::shared_ptr<ScraperMediaProcessor::Job> mResizeJob;
+	std::string mUrl;
 	std::string mSavePath;
 	int mMaxWidth;
 	int mMaxHeight;
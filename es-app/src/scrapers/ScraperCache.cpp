@@ -0,0 +1,344 @@
+#include "scrapers/ScraperCache.h"
+
+#include "scrapers/GamesDBJSONScraperResources.h"
+#include "scrapers/md5.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <set>
+#include <vector>
+
+// Query parameters which identify the user or the software, not the request
+static const char* credentialParameters[] = { "ssid", "sspassword", "devid", "devpassword", "softname", "apikey" };
+
+ScraperCache* ScraperCache::sInstance = nullptr;
+
+ScraperCache* ScraperCache::getInstance()
+{
+	if (sInstance == nullptr)
+		sInstance = new ScraperCache();
+
+	return sInstance;
+}
+
+// Medias are hard linked between the cache & the games folders when they're on the same volume, copied otherwise
+static bool linkOrCopyFile(const std::string& src, const std::string& dst)
+{
+	Utils::FileSystem::removeFile(dst);
+	return Utils::FileSystem::linkFile(src, dst) || Utils::FileSystem::copyFile(src, dst);
+}
+
+ScraperCache::ScraperCache() : mPurged(false), mResponseHits(0), mResponseMisses(0), mMediaHits(0), mMediaMisses(0)
+{
+	mCacheDir = getScrapersResouceDir() + "/cache";
+}
+
+bool ScraperCache::isEnabled()
+{
+	return Settings::getInstance()->getBool("ScraperCache") || isReplayMode();
+}
+
+bool ScraperCache::isReplayMode()
+{
+	return Settings::getInstance()->getBool("ScraperCacheReplay");
+}
+
+std::string ScraperCache::normaliseUrl(const std::string& url)
+{
+	std::string ret = url;
+
+	auto fragment = ret.find('#');
+	if (fragment != std::string::npos)
+		ret = ret.substr(0, fragment);
+
+	std::string query;
+
+	auto queryStart = ret.find('?');
+	if (queryStart != std::string::npos)
+	{
+		query = ret.substr(queryStart + 1);
+		ret = ret.substr(0, queryStart);
+	}
+
+	// scheme & host are case insensitive, user:password@ is dropped
+	auto hostStart = ret.find("://");
+	hostStart = (hostStart == std::string::npos ? 0 : hostStart + 3);
+
+	auto hostEnd = ret.find('/', hostStart);
+	if (hostEnd == std::string::npos)
+		hostEnd = ret.size();
+
+	std::string host = ret.substr(hostStart, hostEnd - hostStart);
+
+	auto userInfo = host.rfind('@');
+	if (userInfo != std::string::npos)
+		host = host.substr(userInfo + 1);
+
+	ret = Utils::String::toLower(ret.substr(0, hostStart)) + Utils::String::toLower(host) + ret.substr(hostEnd);
+
+	if (query.empty())
+		return ret;
+
+	std::vector<std::string> parameters;
+	for (auto parameter : Utils::String::split(query, '&'))
+	{
+		if (parameter.empty())
+			continue;
+
+		std::string name = Utils::String::toLower(parameter.substr(0, parameter.find('=')));
+
+		bool isCredential = false;
+		for (auto credential : credentialParameters)
+			if (name == credential)
+				isCredential = true;
+
+		if (!isCredential)
+			parameters.push_back(parameter);
+	}
+
+	if (parameters.empty())
+		return ret;
+
+	std::sort(parameters.begin(), parameters.end());
+
+	ret += "?";
+	for (size_t i = 0; i < parameters.size(); i++)
+		ret += (i == 0 ? "" : "&") + parameters[i];
+
+	return ret;
+}
+
+ScraperCache::Statistics ScraperCache::getStatistics()
+{
+	Statistics statistics;
+	statistics.responseHits = mResponseHits;
+	statistics.responseMisses = mResponseMisses;
+	statistics.mediaHits = mMediaHits;
+	statistics.mediaMisses = mMediaMisses;
+	return statistics;
+}
+
+std::string ScraperCache::getIndexPath(const std::string& url)
+{
+	return mCacheDir + "/index/" + MD5(normaliseUrl(url)).hexdigest();
+}
+
+std::string ScraperCache::getObjectPath(const std::string& hash)
+{
+	return mCacheDir + "/objects/" + hash;
+}
+
+std::string ScraperCache::findObject(const std::string& url, int maxAgeDays)
+{
+	std::string index = Utils::FileSystem::readAllText(getIndexPath(url));
+	if (index.empty())
+		return "";
+
+	auto tab = index.find('\t');
+	if (tab == std::string::npos)
+		return "";
+
+	// In replay mode, the cache is all we have
+	if (!isReplayMode() && maxAgeDays > 0)
+	{
+		long long time = atoll(index.substr(0, tab).c_str());
+		if ((long long)std::time(nullptr) - time > (long long)maxAgeDays * 86400)
+			return "";
+	}
+
+	std::string path = getObjectPath(Utils::String::trim(index.substr(tab + 1)));
+	if (!Utils::FileSystem::exists(path))
+		return "";
+
+	return path;
+}
+
+void ScraperCache::prepareWrite()
+{
+	Utils::FileSystem::createDirectory(mCacheDir + "/index");
+	Utils::FileSystem::createDirectory(mCacheDir + "/objects");
+
+	if (!mPurged)
+	{
+		mPurged = true;
+		purge();
+	}
+}
+
+// Removes the entries older than both expiry delays, then the objects no entry points to anymore
+void ScraperCache::purge()
+{
+	int responseDays = Settings::getInstance()->getInt("ScraperCacheDays");
+	int mediaDays = Settings::getInstance()->getInt("ScraperCacheMediaDays");
+	if (responseDays <= 0 || mediaDays <= 0)
+		return;
+
+	long long maxAge = (long long)std::max(responseDays, mediaDays) * 86400;
+	long long now = (long long)std::time(nullptr);
+
+	std::set<std::string> usedObjects;
+	int removedEntries = 0;
+	int removedObjects = 0;
+
+	for (auto entry : Utils::FileSystem::getDirInfo(mCacheDir + "/index"))
+	{
+		if (entry.directory)
+			continue;
+
+		std::string index = Utils::FileSystem::readAllText(entry.path);
+
+		auto tab = index.find('\t');
+		if (tab != std::string::npos && now - atoll(index.substr(0, tab).c_str()) <= maxAge)
+		{
+			usedObjects.insert(Utils::String::trim(index.substr(tab + 1)));
+			continue;
+		}
+
+		Utils::FileSystem::removeFile(entry.path);
+		removedEntries++;
+	}
+
+	for (auto object : Utils::FileSystem::getDirInfo(mCacheDir + "/objects"))
+	{
+		if (object.directory || usedObjects.find(Utils::FileSystem::getFileName(object.path)) != usedObjects.cend())
+			continue;
+
+		Utils::FileSystem::removeFile(object.path);
+		removedObjects++;
+	}
+
+	if (removedEntries > 0 || removedObjects > 0)
+		LOG(LogInfo) << "ScraperCache : Purged " << removedEntries << " expired entries and " << removedObjects << " objects";
+}
+
+void ScraperCache::addObject(const std::string& url, const std::string& hash)
+{
+	std::string path = getIndexPath(url);
+
+	std::ofstream index(path + ".tmp", std::ios::binary);
+	if (!index.is_open())
+		return;
+
+	index << (long long)std::time(nullptr) << "\t" << hash;
+	index.close();
+
+	Utils::FileSystem::renameFile(path + ".tmp", path);
+}
+
+bool ScraperCache::getResponse(const std::string& url, std::string& content)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	std::string path = findObject(url, Settings::getInstance()->getInt("ScraperCacheDays"));
+	if (path.empty())
+	{
+		mResponseMisses++;
+		return false;
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		mResponseMisses++;
+		return false;
+	}
+
+	content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	mResponseHits++;
+
+	LOG(LogDebug) << "ScraperCache : Response served from cache " << normaliseUrl(url);
+	return true;
+}
+
+void ScraperCache::putResponse(const std::string& url, const std::string& content)
+{
+	if (content.empty() || isReplayMode())
+		return;
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	prepareWrite();
+
+	std::string hash = MD5(content).hexdigest();
+	std::string path = getObjectPath(hash);
+
+	if (!Utils::FileSystem::exists(path))
+	{
+		std::ofstream file(path + ".tmp", std::ios::binary);
+		if (!file.is_open())
+			return;
+
+		file.write(content.c_str(), content.size());
+		file.close();
+
+		if (!Utils::FileSystem::renameFile(path + ".tmp", path))
+			return;
+	}
+
+	addObject(url, hash);
+}
+
+bool ScraperCache::getMedia(const std::string& url, const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	std::string object = findObject(url, Settings::getInstance()->getInt("ScraperCacheMediaDays"));
+	if (object.empty())
+	{
+		mMediaMisses++;
+		return false;
+	}
+
+	if (!linkOrCopyFile(object, path + ".part") || !Utils::FileSystem::renameFile(path + ".part", path))
+	{
+		Utils::FileSystem::removeFile(path + ".part");
+		mMediaMisses++;
+		return false;
+	}
+
+	mMediaHits++;
+
+	LOG(LogDebug) << "ScraperCache : Media served from cache " << normaliseUrl(url);
+	return true;
+}
+
+void ScraperCache::putMedia(const std::string& url, const std::string& path)
+{
+	if (isReplayMode())
+		return;
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return;
+
+	MD5 md5;
+
+	char buffer[64 * 1024];
+	while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+		md5.update(buffer, (MD5::size_type)file.gcount());
+
+	file.close();
+
+	std::string hash = md5.finalize().hexdigest();
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	prepareWrite();
+
+	std::string object = getObjectPath(hash);
+	if (!Utils::FileSystem::exists(object))
+	{
+		if (!linkOrCopyFile(path, object + ".tmp") || !Utils::FileSystem::renameFile(object + ".tmp", object))
+		{
+			Utils::FileSystem::removeFile(object + ".tmp");
+			return;
+		}
+	}
+
+	addObject(url, hash);
+}
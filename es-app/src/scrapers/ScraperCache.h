@@ -0,0 +1,66 @@
+#pragma once
+#ifndef ES_APP_SCRAPERS_SCRAPER_CACHE_H
+#define ES_APP_SCRAPERS_SCRAPER_CACHE_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+// Keeps the raw scraper API responses & downloaded medias in <home>/.emulationstation/scrapers/cache.
+// Requests are keyed by their normalised url (without credentials), contents are stored once by their md5 :
+//   index/<md5 of url>    -> "<time>\t<md5 of content>"
+//   objects/<md5 of content>
+// Medias are hard linked to the scraped files when possible. Expired entries & their objects are purged on the first write of a session.
+// In replay mode, nothing is requested from the network : everything is served from the cache, whatever its age.
+class ScraperCache
+{
+public:
+	struct Statistics
+	{
+		int responseHits;
+		int responseMisses;
+		int mediaHits;
+		int mediaMisses;
+	};
+
+	static ScraperCache* getInstance();
+
+	static bool isEnabled();
+	static bool isReplayMode();
+
+	bool getResponse(const std::string& url, std::string& content);
+	void putResponse(const std::string& url, const std::string& content);
+
+	// Copies the cached media to path
+	bool getMedia(const std::string& url, const std::string& path);
+	void putMedia(const std::string& url, const std::string& path);
+
+	// Removes the query parameters carrying credentials & sorts the others, so the same request always has the same key
+	static std::string normaliseUrl(const std::string& url);
+
+	Statistics getStatistics();
+
+private:
+	ScraperCache();
+
+	std::string findObject(const std::string& url, int maxAgeDays);
+	void prepareWrite();
+	void purge();
+	void addObject(const std::string& url, const std::string& hash);
+
+	std::string getIndexPath(const std::string& url);
+	std::string getObjectPath(const std::string& hash);
+
+	static ScraperCache* sInstance;
+
+	std::mutex mLock;
+	std::string mCacheDir;
+	bool mPurged;
+
+	std::atomic<int> mResponseHits;
+	std::atomic<int> mResponseMisses;
+	std::atomic<int> mMediaHits;
+	std::atomic<int> mMediaMisses;
+};
+
+#endif // ES_APP_SCRAPERS_SCRAPER_CACHE_H
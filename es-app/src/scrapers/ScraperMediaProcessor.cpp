@@ -0,0 +1,147 @@
+#include "scrapers/ScraperMediaProcessor.h"
+
+#include "scrapers/Scraper.h"
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include <algorithm>
+
+// Resizing is short compared to the downloads, a couple of workers keep up with them
+#define MAX_MEDIA_THREADS 2
+
+ScraperMediaProcessor* ScraperMediaProcessor::sInstance = nullptr;
+
+ScraperMediaProcessor* ScraperMediaProcessor::getInstance()
+{
+	if (sInstance == nullptr)
+		sInstance = new ScraperMediaProcessor();
+
+	return sInstance;
+}
+
+void ScraperMediaProcessor::deinit()
+{
+	if (sInstance != nullptr)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+}
+
+ScraperMediaProcessor::ScraperMediaProcessor() : mRunning(true), mProcessed(0), mFailed(0), mInputBytes(0), mWorkTimeMs(0)
+{
+	int threads = Settings::getInstance()->getInt("ScraperMediaThreads");
+	if (threads < 0)
+		threads = std::max(1, std::min(MAX_MEDIA_THREADS, (int)std::thread::hardware_concurrency() - 1));
+	else
+		threads = std::min(threads, std::max(1, (int)std::thread::hardware_concurrency()));
+
+	for (int i = 0; i < threads; i++)
+		mThreads.push_back(std::thread(&ScraperMediaProcessor::run, this));
+}
+
+ScraperMediaProcessor::~ScraperMediaProcessor()
+{
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		mRunning = false;
+	}
+
+	mEvent.notify_all();
+
+	for (auto& thread : mThreads)
+		thread.join();
+
+	// Jobs never started are reported as failed
+	for (auto& job : mJobs)
+		job->mDone = true;
+}
+
+std::shared_ptr<ScraperMediaProcessor::Job> ScraperMediaProcessor::resizeImage(const std::string& path, int maxWidth, int maxHeight)
+{
+	auto job = std::make_shared<Job>(path, maxWidth, maxHeight);
+
+	if (mThreads.empty())
+	{
+		process(job);
+		return job;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		mJobs.push_back(job);
+	}
+
+	mEvent.notify_one();
+	return job;
+}
+
+void ScraperMediaProcessor::run()
+{
+	while (true)
+	{
+		std::shared_ptr<Job> job;
+
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+			mEvent.wait(lock, [this] { return !mRunning || !mJobs.empty(); });
+
+			if (!mRunning)
+				return;
+
+			job = mJobs.front();
+			mJobs.pop_front();
+		}
+
+		process(job);
+	}
+}
+
+void ScraperMediaProcessor::process(const std::shared_ptr<Job>& job)
+{
+	auto start = std::chrono::steady_clock::now();
+	long long size = Utils::FileSystem::getFileSize(job->mPath);
+
+	job->mSuccess = ::resizeImage(job->mPath, job->mMaxWidth, job->mMaxHeight);
+
+	auto end = std::chrono::steady_clock::now();
+
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+
+		if (mProcessed + mFailed == 0)
+			mFirstJob = start;
+
+		mLastJob = end;
+
+		if (job->mSuccess)
+			mProcessed++;
+		else
+			mFailed++;
+
+		mInputBytes += size;
+		mWorkTimeMs += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+	}
+
+	job->mDone = true;
+}
+
+void ScraperMediaProcessor::logStatistics()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	int count = mProcessed + mFailed;
+	if (count == 0)
+		return;
+
+	long long elapsedMs = std::max(1LL, (long long)std::chrono::duration_cast<std::chrono::milliseconds>(mLastJob - mFirstJob).count());
+
+	LOG(LogInfo) << "ScraperMediaProcessor : " << mProcessed << " images resized, " << mFailed << " failed (" << (mInputBytes / 1024) << " KB) in " << elapsedMs << " ms"
+		<< " on " << std::max((size_t)1, mThreads.size()) << " thread(s) - " << (count * 1000.0 / elapsedMs) << " images/s, "
+		<< (mWorkTimeMs / count) << " ms per image";
+
+	mProcessed = 0;
+	mFailed = 0;
+	mInputBytes = 0;
+	mWorkTimeMs = 0;
+}
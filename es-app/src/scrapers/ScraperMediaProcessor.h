@@ -0,0 +1,72 @@
+#pragma once
+#ifndef ES_APP_SCRAPERS_SCRAPER_MEDIA_PROCESSOR_H
+#define ES_APP_SCRAPERS_SCRAPER_MEDIA_PROCESSOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Resizes the downloaded images on worker threads, so that the thread polling the downloads keeps starting new ones.
+// The number of workers is set by ScraperMediaThreads : -1 = one per core but one (2 at most), 0 = resize on the calling thread.
+// A failed resize is reported by Job::succeeded() and counted apart in the statistics.
+class ScraperMediaProcessor
+{
+public:
+	class Job
+	{
+	public:
+		Job(const std::string& path, int maxWidth, int maxHeight) : mPath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight), mDone(false), mSuccess(false) { }
+
+		bool isDone() { return mDone; }
+		bool succeeded() { return mSuccess; }
+
+	private:
+		friend class ScraperMediaProcessor;
+
+		std::string mPath;
+		int mMaxWidth;
+		int mMaxHeight;
+
+		std::atomic<bool> mDone;
+		bool mSuccess;
+	};
+
+	static ScraperMediaProcessor* getInstance();
+	static void deinit();
+
+	std::shared_ptr<Job> resizeImage(const std::string& path, int maxWidth, int maxHeight);
+
+	// Logs how many images were processed, and how fast, since the last call
+	void logStatistics();
+
+private:
+	ScraperMediaProcessor();
+	~ScraperMediaProcessor();
+
+	void run();
+	void process(const std::shared_ptr<Job>& job);
+
+	static ScraperMediaProcessor* sInstance;
+
+	std::mutex mLock;
+	std::condition_variable mEvent;
+	std::deque<std::shared_ptr<Job>> mJobs;
+	std::vector<std::thread> mThreads;
+	bool mRunning;
+
+	// Statistics
+	int mProcessed;
+	int mFailed;
+	long long mInputBytes;
+	long long mWorkTimeMs;
+	std::chrono::steady_clock::time_point mFirstJob;
+	std::chrono::steady_clock::time_point mLastJob;
+};
+
+#endif // ES_APP_SCRAPERS_SCRAPER_MEDIA_PROCESSOR_H
@@ -10,7 +10,7 @@
 #include <pugixml/src/pugixml.hpp>
 #include <cstring>
 #include "EsLocale.h"
-#include "md5.h"
+#include "scrapers/RomHashCache.h"
 #include <thread>
 
 using namespace PlatformIds;
@@ -179,41 +179,9 @@ void screenscraper_generate_scraper_requests(const ScraperSearchParams& params,
 		path += "&romtype=rom";
 
 		// Use md5 to search scrapped game
-		int length = Utils::FileSystem::getFileSize(params.game->getFullPath());
-		if (length <= 131072 * 1024) // 128 Mb max
-		{
-			try
-			{
-				// 64 Kb blocks
-				#define MD5BUFFERSIZE 64 * 1024
-
-				char* buffer = new char[MD5BUFFERSIZE];
-				if (buffer)
-				{
-					size_t size;
-
-					FILE* file = fopen(params.game->getFullPath().c_str(), "rb");
-					if (file)
-					{
-						MD5 md5 = MD5();
-
-						while (size = fread(buffer, 1, MD5BUFFERSIZE, file))
-							md5.update(buffer, size);
-
-						md5.finalize();
-
-						std::string val = md5.hexdigest();
-						if (!val.empty())
-							path += "&md5=" + val;
-
-						fclose(file);
-					}
-
-					delete buffer;
-				}
-			}
-			catch (std::bad_alloc& ex) {}
-		}
+		RomHashes hashes;
+		if (RomHashCache::getInstance()->getHashes(params.game->getFullPath(), hashes, SCREENSCRAPER_MAX_HASHED_ROM_SIZE) && !hashes.md5.empty())
+			path += "&md5=" + hashes.md5;
 	}
 	else
 		path = ssConfig.getGameSearchUrl(params.nameOverride, true);
@@ -250,12 +218,8 @@ void screenscraper_generate_scraper_requests(const ScraperSearchParams& params,
 }
 
 // Process should return false only when we reached a maximum scrap by minute, to retry
-bool ScreenScraperRequest::process(const std::unique_ptr<HttpReq>& req, std::vector<ScraperSearchResult>& results)
+bool ScreenScraperRequest::process(const std::string& content, std::vector<ScraperSearchResult>& results)
 {
-	assert(req->status() == HttpReq::REQ_SUCCESS);
-
-	auto content = req->getContent();
-
 	pugi::xml_document doc;
 	pugi::xml_parse_result parseResult = doc.load(content.c_str());
 
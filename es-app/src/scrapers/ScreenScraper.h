@@ -7,6 +7,9 @@
 
 namespace pugi { class xml_document; }
 
+// Bigger roms are searched by name only
+#define SCREENSCRAPER_MAX_HASHED_ROM_SIZE (128LL * 1024 * 1024)
+
 
 void screenscraper_generate_scraper_requests(const ScraperSearchParams& params, std::queue< std::unique_ptr<ScraperRequest> >& requests,
 	std::vector<ScraperSearchResult>& results);
@@ -57,7 +60,7 @@ public:
 	} configuration;
 
 protected:
-	bool process(const std::unique_ptr<HttpReq>& req, std::vector<ScraperSearchResult>& results) override;
+	bool process(const std::string& content, std::vector<ScraperSearchResult>& results) override;
 	std::string ensureUrl(const std::string url);
 
 	void processList(const pugi::xml_document& xmldoc, std::vector<ScraperSearchResult>& results);
@@ -1,33 +1,96 @@
 #include "ThreadedScraper.h"
 #include "Window.h"
 #include "FileData.h"
+#include "GameCatalogue.h"
+#include "Gamelist.h"
+#include "Settings.h"
+#include "SystemData.h"
 #include "components/AsyncNotificationComponent.h"
 #include "EsLocale.h"
+#include <algorithm>
 
 #define GUIICON _U("\uF03E ")
 
-ThreadedScraper* ThreadedScraper::mInstance = nullptr;
-bool ThreadedScraper::mPaused = false;
+// Scraped metadata is written to the gamelists every SCRAPER_COMMIT_BATCH games, and when scraping ends
+#define SCRAPER_COMMIT_BATCH 50
 
-ThreadedScraper::ThreadedScraper(Window* window, const std::queue<ScraperSearchParams>& searches)
-	: mSearchQueue(searches), mWindow(window)
+std::atomic<ThreadedScraper*> ThreadedScraper::mInstance(nullptr);
+std::atomic<bool> ThreadedScraper::mPaused(false);
+std::mutex ThreadedScraper::mInstanceLock;
+
+ScraperRateLimiter::ScraperRateLimiter(int requestsPerMinute, int burst)
+{
+	mBurst = std::max(1, burst);
+	mTokens = mBurst;
+	mTokensPerMs = requestsPerMinute <= 0 ? 0 : requestsPerMinute / 60000.0;
+	mLastRefill = std::chrono::steady_clock::now();
+}
+
+bool ScraperRateLimiter::tryAcquire()
+{
+	// No limit
+	if (mTokensPerMs == 0)
+		return true;
+
+	auto now = std::chrono::steady_clock::now();
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastRefill).count();
+
+	mTokens = std::min(mBurst, mTokens + elapsed * mTokensPerMs);
+	mLastRefill = now;
+
+	if (mTokens < 1.0)
+		return false;
+
+	mTokens -= 1.0;
+	return true;
+}
+
+ThreadedScraper::ThreadedScraper(Window* window, const std::queue<ScraperSearchParams>& searches, const GameScrapedCallback& onGameScraped)
+	: mSearchQueue(searches), mWindow(window), mOnGameScraped(onGameScraped), mWndNotification(nullptr),
+	mRateLimiter(Settings::getInstance()->getInt("ScraperRequestsPerMinute"), Settings::getInstance()->getInt("ScraperThreads"))
 {
 	mExit = false;
 	mTotal = (int) mSearchQueue.size();
+	mScraped = 0;
+	mUncommittedGames = 0;
 
-	mWndNotification = new AsyncNotificationComponent(window);
+	mMaxSearches = std::max(1, Settings::getInstance()->getInt("ScraperThreads"));
+	mMaxDownloads = std::max(1, Settings::getInstance()->getInt("ScraperMaxDownloads"));
 
-	mWindow->registerNotificationComponent(mWndNotification);
-	search(mSearchQueue.front());
-	mHandle = new std::thread(&ThreadedScraper::run, this);	
+	// Without window, the scraper runs headless (batch mode)
+	if (mWindow != nullptr)
+	{
+		mWndNotification = new AsyncNotificationComponent(window);
+		mWindow->registerNotificationComponent(mWndNotification);
+	}
+
+	// Hash the next roms while the current ones are searched
+	std::vector<ScraperSearchParams> pending;
+	std::queue<ScraperSearchParams> queue = mSearchQueue;
+	while (!queue.empty())
+	{
+		pending.push_back(queue.front());
+		queue.pop();
+	}
+
+	mCancelPrepare = false;
+	mPrepareThread = std::thread([this, pending] { prepareScraperSearches(pending, mCancelPrepare); });
+
+	startNextSearch();
+
+	ThreadedScraper::mInstance = this;
+
+	// the thread owns the scraper, which deletes itself when it's done
+	std::thread(&ThreadedScraper::run, this).detach();
 }
 
 ThreadedScraper::~ThreadedScraper()
 {
-	mWindow->unRegisterNotificationComponent(mWndNotification);
-	delete mWndNotification;
-
-	ThreadedScraper::mInstance = nullptr;
+	if (mWndNotification != nullptr)
+	{
+		mWindow->unRegisterNotificationComponent(mWndNotification);
+		delete mWndNotification;
+	}
 }
 
 std::string ThreadedScraper::formatGameName(FileData* game)
@@ -37,134 +100,277 @@ std::string ThreadedScraper::formatGameName(FileData* game)
 
 void ThreadedScraper::search(const ScraperSearchParams& params)
 {
-	mCurrentAction = "";
-	mLastSearch = params;
-	mSearchHandle = startScraperSearch(params);
+	PendingSearch search;
+	search.params = params;
+	search.handle = startScraperSearch(params);
+	mSearches.push_back(std::move(search));
 
-	std::string idx = std::to_string(mTotal + 1- mSearchQueue.size()) + "/" + std::to_string(mTotal);
+	if (mWndNotification == nullptr)
+		return;
 
-	mWndNotification->updateTitle(GUIICON + _("SCRAPING") + "... " + idx);
+	mCurrentAction = "";
 	mWndNotification->updateText(formatGameName(params.game), _("Searching")+"...");
 	mWndNotification->updatePercent(-1);
 }
 
-void ThreadedScraper::run()
+// Starts the next queued search, if a search slot is free and the rate limiter allows it
+bool ThreadedScraper::startNextSearch()
+{
+	if (mSearchQueue.empty() || (int)mSearches.size() >= mMaxSearches)
+		return false;
+
+	// Don't search further while found medias are waiting for a download slot
+	if ((int)mMedias.size() >= mMaxDownloads * 2)
+		return false;
+
+	if (!mRateLimiter.tryAcquire())
+		return false;
+
+	search(mSearchQueue.front());
+	mSearchQueue.pop();
+	return true;
+}
+
+void ThreadedScraper::updateSearches()
 {
-	while (!mExit && !mSearchQueue.empty())
+	for (auto it = mSearches.begin(); it != mSearches.end(); )
 	{
-		if (mPaused)
+		if (it->handle->status() == ASYNC_IN_PROGRESS)
 		{
-			while (!mExit && mPaused)
-			{
-				std::this_thread::yield();
-				std::this_thread::sleep_for(std::chrono::milliseconds(500));
-			}
+			it++;
+			continue;
 		}
 
-		if (mSearchHandle && mSearchHandle->status() != ASYNC_IN_PROGRESS)
-		{
-			auto status = mSearchHandle->status();
-			auto results = mSearchHandle->getResults();
-			auto statusString = mSearchHandle->getStatusString();
+		auto status = it->handle->status();
+		auto results = it->handle->getResults();
+		auto statusString = it->handle->getStatusString();
+		ScraperSearchParams params = it->params;
 
-			mSearchHandle.reset();
+		it = mSearches.erase(it);
 
-			if (status == ASYNC_DONE)
+		if (status == ASYNC_DONE && results.size() > 0)
+		{
+			if (results[0].hadMedia())
 			{
-				if (results.size() > 0)
-				{
-					if (results[0].hadMedia())
-						processMedias(results[0]);
-					else
-						acceptResult(results[0]);
-				}
+				processMedias(params, results[0]);
+				continue;
 			}
-			else if (status == ASYNC_ERROR)
-				mErrors.push_back(statusString);
-		}
 
-		if (mMDResolveHandle && mMDResolveHandle->status() != ASYNC_IN_PROGRESS)
+			acceptResult(params, results[0]);
+		}
+		else if (status == ASYNC_ERROR)
 		{
-			auto status = mMDResolveHandle->status();
-			auto result = mMDResolveHandle->getResult();
-			auto statusString = mMDResolveHandle->getStatusString();
+			mErrors.push_back(statusString);
+			gameScraped(params, statusString);
+			continue;
+		}
 
-			mCurrentAction = "";
-			mMDResolveHandle.reset();
+		gameScraped(params);
+	}
+}
 
-			if (status == ASYNC_DONE)
-				acceptResult(result);
-			else if (status == ASYNC_ERROR)
-				mErrors.push_back(statusString);
-		}
+void ThreadedScraper::updateMedias()
+{
+	int downloads = 0;
 
-		if (mMDResolveHandle && mMDResolveHandle->status() == ASYNC_IN_PROGRESS)
+	for (auto it = mMedias.begin(); it != mMedias.end(); )
+	{
+		if (it->handle == nullptr)
 		{
-			std::string action = mMDResolveHandle->getCurrentItem();
-			if (action != mCurrentAction)
+			if (downloads >= mMaxDownloads)
 			{
-				mCurrentAction = action;
-				mWndNotification->updateText(formatGameName(mLastSearch.game), "Downloading "+ mCurrentAction);
+				it++;
+				continue;
 			}
 
-			mWndNotification->updatePercent(mMDResolveHandle->getPercent());
+			it->handle = resolveMetaDataAssets(it->result, it->params);
 		}
 
-		if (mSearchHandle == nullptr && mMDResolveHandle == nullptr)
+		if (it->handle->status() == ASYNC_IN_PROGRESS)
 		{
-			mSearchQueue.pop();
+			downloads++;
+			it++;
+			continue;
+		}
 
-			if (!mSearchQueue.empty())
-				search(mSearchQueue.front());
+		auto status = it->handle->status();
+		auto result = it->handle->getResult();
+		auto statusString = it->handle->getStatusString();
+		ScraperSearchParams params = it->params;
+
+		it = mMedias.erase(it);
+
+		if (status == ASYNC_DONE)
+			acceptResult(params, result);
+		else if (status == ASYNC_ERROR)
+		{
+			mErrors.push_back(statusString);
+			gameScraped(params, statusString);
+			continue;
 		}
-		else
+
+		gameScraped(params);
+	}
+}
+
+void ThreadedScraper::updateNotification()
+{
+	if (mWndNotification == nullptr)
+		return;
+
+	std::string idx = std::to_string(std::min(mTotal, mScraped + 1)) + "/" + std::to_string(mTotal);
+	mWndNotification->updateTitle(GUIICON + _("SCRAPING") + "... " + idx);
+
+	// Show the oldest running download
+	for (auto& medias : mMedias)
+	{
+		if (medias.handle == nullptr || medias.handle->status() != ASYNC_IN_PROGRESS)
+			continue;
+
+		std::string action = medias.handle->getCurrentItem();
+		if (action != mCurrentAction)
 		{
-			std::this_thread::yield();
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			mCurrentAction = action;
+			mWndNotification->updateText(formatGameName(medias.params.game), "Downloading " + mCurrentAction);
 		}
+
+		mWndNotification->updatePercent(medias.handle->getPercent());
+		break;
 	}
+}
+
+void ThreadedScraper::run()
+{
+	while (!mExit && (!mSearchQueue.empty() || !mSearches.empty() || !mMedias.empty()))
+	{
+		if (mPaused)
+		{
+			while (!mExit && mPaused)
+			{
+				std::this_thread::yield();
+				std::this_thread::sleep_for(std::chrono::milliseconds(500));
+			}
+		}
+
+		updateSearches();
+		updateMedias();
+
+		while (startNextSearch());
+
+		updateNotification();
+
+		// Wake up as soon as a transfer completes
+		HttpReq::waitAny(10);
+	}
+
+	commitGamelists();
+	ScraperMediaProcessor::getInstance()->logStatistics();
+
+	mCancelPrepare = true;
+	mPrepareThread.join();
 	
-	if (!mExit)
-		mWindow->displayNotificationMessage(GUIICON + _("SCRAPING FINISHED. REFRESH UPDATE GAMES LISTS TO APPLY CHANGES."));
+	if (!mExit && mWindow != nullptr)
+		mWindow->displayNotificationMessage(GUIICON + _("SCRAPING FINISHED. THE GAMELISTS ARE SAVED."));
+
+	// stop() can't reach the scraper anymore once it's being deleted, and a new one can start meanwhile
+	{
+		std::unique_lock<std::mutex> lock(mInstanceLock);
+		ThreadedScraper::mInstance = nullptr;
+	}
 
 	delete this;
-	ThreadedScraper::mInstance = nullptr;
 }
 
-void ThreadedScraper::processMedias(ScraperSearchResult result)
+// The games are edited & their gamelists saved on the UI thread : the scraper changes them there too, in order.
+// Headless, there's no UI thread and everything runs right away. The functions mustn't use this, which can be gone when they run.
+void ThreadedScraper::runOnGames(const std::function<void()>& func)
 {
-	ScraperSearchParams& search = mSearchQueue.front();
+	if (mWindow == nullptr)
+		func();
+	else
+		mWindow->postToUiThread([func](Window*) { func(); });
+}
 
-	if (result.hadMedia())
-		mMDResolveHandle = resolveMetaDataAssets(result, mLastSearch);
+void ThreadedScraper::processMedias(const ScraperSearchParams& params, const ScraperSearchResult& result)
+{
+	// Downloads start in updateMedias, when a slot is free
+	PendingMedias medias;
+	medias.params = params;
+	medias.result = result;
+	mMedias.push_back(std::move(medias));
+
+	FileData* game = params.game;
+	MetaDataList mdl = result.mdl;
+	runOnGames([game, mdl] { game->metadata.importScrappedMetadata(mdl); });
+}
 
-	search.game->metadata.importScrappedMetadata(result.mdl);
+void ThreadedScraper::acceptResult(const ScraperSearchParams& params, const ScraperSearchResult& result)
+{
+	FileData* game = params.game;
+	MetaDataList mdl = result.mdl;
+	runOnGames([game, mdl] { game->metadata = mdl; });
 }
 
-void ThreadedScraper::acceptResult(const ScraperSearchResult& result)
+void ThreadedScraper::gameScraped(const ScraperSearchParams& params, const std::string& error)
 {
-	ScraperSearchParams& search = mSearchQueue.front();
-	search.game->metadata = result.mdl;
+	mScraped++;
+
+	if (mOnGameScraped != nullptr)
+		mUnreportedGames.push_back(std::make_pair(params, error));
+
+	// only the games whose metadata changed are written by updateGamelist
+	mChangedSystems.insert(params.system);
+
+	FileData* game = params.game;
+	runOnGames([game]
+	{
+		if (!game->metadata.wasChanged())
+			return;
+
+		GameCatalogue::getInstance()->update(game);
+		FolderData::invalidateAllDisplayLists();
+		game->getSystem()->updateDisplayedGameCount();
+	});
+
+	if (++mUncommittedGames >= SCRAPER_COMMIT_BATCH)
+		commitGamelists();
 }
 
-void ThreadedScraper::start(Window* window, const std::queue<ScraperSearchParams>& searches)
+void ThreadedScraper::commitGamelists()
+{
+	std::set<SystemData*> systems = mChangedSystems;
+	std::vector<std::pair<ScraperSearchParams, std::string>> games = mUnreportedGames;
+	GameScrapedCallback onGameScraped = mOnGameScraped;
+
+	runOnGames([systems, games, onGameScraped]
+	{
+		for (auto system : systems)
+			updateGamelist(system);
+
+		// Games are reported once their metadata is safely written
+		for (auto& game : games)
+			onGameScraped(game.first, game.second);
+	});
+
+	mChangedSystems.clear();
+	mUncommittedGames = 0;
+	mUnreportedGames.clear();
+}
+
+void ThreadedScraper::start(Window* window, const std::queue<ScraperSearchParams>& searches, const GameScrapedCallback& onGameScraped)
 {
 	if (ThreadedScraper::mInstance != nullptr)
 		return;
 
-	ThreadedScraper::mInstance = new ThreadedScraper(window, searches);
+	new ThreadedScraper(window, searches, onGameScraped);
 }
 
 void ThreadedScraper::stop()
 {
-	auto thread = ThreadedScraper::mInstance;
-	if (thread == nullptr)
-		return;
+	std::unique_lock<std::mutex> lock(mInstanceLock);
 
-	try
-	{
+	ThreadedScraper* thread = ThreadedScraper::mInstance;
+	if (thread != nullptr)
 		thread->mExit = true;
-	}
-	catch (...) {}
 }
 
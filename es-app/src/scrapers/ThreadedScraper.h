@@ -1,13 +1,40 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <set>
 #include <thread>
 #include "Scraper.h"
 #include "components/AsyncNotificationComponent.h"
 
+// Limits how often new scraper requests are started, so that the scraper site quotas are respected
+class ScraperRateLimiter
+{
+public:
+	ScraperRateLimiter(int requestsPerMinute, int burst);
+
+	// Returns true and consumes a token if a request can be started now
+	bool tryAcquire();
+
+private:
+	double mTokens;
+	double mBurst;
+	double mTokensPerMs;
+	std::chrono::steady_clock::time_point mLastRefill;
+};
+
 class ThreadedScraper
 {
 public:
-	static void start(Window* window, const std::queue<ScraperSearchParams>& searches);
+	// Called for each game once its metadata is written to the gamelist, error is empty on success.
+	// It runs on the UI thread when there's a window, on the scraper thread otherwise.
+	typedef std::function<void(const ScraperSearchParams& params, const std::string& error)> GameScrapedCallback;
+
+	// window can be null to scrape without any notification
+	static void start(Window* window, const std::queue<ScraperSearchParams>& searches, const GameScrapedCallback& onGameScraped = nullptr);
 	static void stop();
 	static bool isRunning() { return mInstance != nullptr; }
 	
@@ -15,7 +42,7 @@ public:
 	static void resume() { mPaused = false; }
 
 private:
-	ThreadedScraper(Window* window, const std::queue<ScraperSearchParams>& searches);
+	ThreadedScraper(Window* window, const std::queue<ScraperSearchParams>& searches, const GameScrapedCallback& onGameScraped);
 	~ThreadedScraper();
 
 	Window* mWindow;
@@ -26,23 +53,58 @@ private:
 
 	void run();
 
-	std::thread* mHandle;
 	std::queue<ScraperSearchParams> mSearchQueue;
 
-	ScraperSearchParams mLastSearch;
-	std::unique_ptr<ScraperSearchHandle> mSearchHandle;
-	std::unique_ptr<MDResolveHandle> mMDResolveHandle;
+	std::thread mPrepareThread;
+	std::atomic<bool> mCancelPrepare;
+
+	// Games are pipelined : up to mMaxSearches searches and mMaxDownloads media downloads run at the same time
+	struct PendingSearch
+	{
+		ScraperSearchParams params;
+		std::unique_ptr<ScraperSearchHandle> handle;
+	};
+
+	struct PendingMedias
+	{
+		ScraperSearchParams params;
+		ScraperSearchResult result;
+		std::unique_ptr<MDResolveHandle> handle;
+	};
+
+	std::list<PendingSearch> mSearches;
+	std::list<PendingMedias> mMedias;	// handle is null until a download slot is free
+
+	int mMaxSearches;
+	int mMaxDownloads;
+	ScraperRateLimiter mRateLimiter;
+
+	bool startNextSearch();
+	void updateSearches();
+	void updateMedias();
+	void updateNotification();
 
 	void search(const ScraperSearchParams& params);
-	void processMedias(ScraperSearchResult result);
-	void acceptResult(const ScraperSearchResult& result);
+	void processMedias(const ScraperSearchParams& params, const ScraperSearchResult& result);
+	void acceptResult(const ScraperSearchParams& params, const ScraperSearchResult& result);
+	void gameScraped(const ScraperSearchParams& params, const std::string& error = "");
+	void commitGamelists();
+	void runOnGames(const std::function<void()>& func);
 	
 	std::string formatGameName(FileData* game);
 
+	// Systems with scraped metadata not written to their gamelist yet
+	std::set<SystemData*> mChangedSystems;
+	int mUncommittedGames;
+
+	GameScrapedCallback mOnGameScraped;
+	std::vector<std::pair<ScraperSearchParams, std::string>> mUnreportedGames;
+
 	int mTotal;
-	bool mExit;
+	int mScraped;
+	std::atomic<bool> mExit;
 
-	static bool mPaused;
-	static ThreadedScraper* mInstance;
+	static std::atomic<bool> mPaused;
+	static std::atomic<ThreadedScraper*> mInstance;
+	static std::mutex mInstanceLock; // held by stop() & when the scraper forgets its instance
 };
-
@@ -14,6 +14,9 @@
 const int logoBuffersLeft[] = { -5, -2, -1 };
 const int logoBuffersRight[] = { 1, 2, 5 };
 
+// extra entries loaded beyond the visible carousel and the scrolling buffers
+const int CAROUSEL_PREFETCH_COUNT = 2;
+
 SystemView::SystemView(Window* window) : IList<SystemViewData, SystemData*>(window, LIST_SCROLL_STYLE_SLOW, LIST_ALWAYS_LOOP),
 										 mViewNeedsReload(true),
 										 mSystemInfo(window, "SYSTEM INFO", Font::get(FONT_SIZE_SMALL), 0x33333300, ALIGN_CENTER)
@@ -27,6 +30,7 @@ SystemView::SystemView(Window* window) : IList<SystemViewData, SystemData*>(wind
 	mShowing = false;
 	mLastCursor = 0;
 	mStaticBackground = nullptr;
+	mLogoSize = Vector2f::Zero();
 
 	setSize((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
 	populate();
@@ -62,120 +66,175 @@ void SystemView::populate()
 
 	for (auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
 	{
-		const std::shared_ptr<ThemeData>& theme = (*it)->getTheme();
-
 		if (mViewNeedsReload)
-			getViewElements(theme);
+			getViewElements((*it)->getTheme());
 
 		if (!(*it)->isVisible())
 			continue;
 
+		// logos and extras are loaded on demand, see updateLoadedEntries
 		Entry e;
 		e.name = (*it)->getName();
 		e.object = *it;
 		e.data.logoIsImage = false;
+		this->add(e);
+	}
 
-		// make logo
-		const ThemeData::ThemeElement* logoElem = theme->getElement("system", "logo", "image");
-		if (logoElem && logoElem->has("path"))
+	if (mEntries.size() == 0)
+	{
+		// Something is wrong, there is not a single system to show, check if UI mode is not full
+		if (!UIModeController::getInstance()->isUIModeFull())
 		{
-			std::string path = logoElem->get<std::string>("path");
-			std::string defaultPath = logoElem->has("default") ? logoElem->get<std::string>("default") : "";
-			
-			if ((!path.empty() && ResourceManager::getInstance()->fileExists(path))
-				|| (!defaultPath.empty() && ResourceManager::getInstance()->fileExists(defaultPath)))
-			{								
-				// Remove dynamic flags for png & jpg files : themes can contain oversized images that can't be unloaded by the TextureResource manager
-				ImageComponent* logo = new ImageComponent(mWindow, false, Utils::String::toLower(Utils::FileSystem::getExtension(path)) != ".svg");
-				logo->setMaxSize(carouselLogoSize() * mCarousel.logoScale);						
-				logo->applyTheme(theme, "system", "logo", ThemeFlags::COLOR | ThemeFlags::ALIGNMENT | ThemeFlags::VISIBLE); //  ThemeFlags::PATH | 
-
-				// Process here to be enable to set max picture size
-				auto elem = theme->getElement("system", "logo", "image");
-				if (elem && elem->has("path"))
-				{
-					auto path = elem->get<std::string>("path");
-					if (Utils::FileSystem::exists(path))
-						logo->setImage(path, (elem->has("tile") && elem->get<bool>("tile")), MaxSizeInfo(carouselLogoSize() * mCarousel.logoScale));
-				}
-				
-				logo->setRotateByTargetSize(true);
-				e.data.logo = std::shared_ptr<GuiComponent>(logo);
-				e.data.logoIsImage = true;
-			}
+			Settings::getInstance()->setString("UIMode", "Full");
+			mWindow->pushGui(new GuiMsgBox(mWindow, "The selected UI mode has nothing to show,\n returning to UI mode: FULL", "OK", nullptr));
 		}
+	}
 
-		if (!e.data.logo)
-		{
-			// no logo in theme; use text
-			TextComponent* text = new TextComponent(mWindow,
-				(*it)->getFullName(),
-				Font::get(FONT_SIZE_LARGE),
-				0x000000FF,
-				ALIGN_CENTER);
-			text->setSize(carouselLogoSize() * mCarousel.logoScale);
-			text->applyTheme((*it)->getTheme(), "system", "logoText", ThemeFlags::FONT_PATH | ThemeFlags::FONT_SIZE | ThemeFlags::COLOR | ThemeFlags::FORCE_UPPERCASE | ThemeFlags::LINE_SPACING | ThemeFlags::TEXT);
-			e.data.logo = std::shared_ptr<GuiComponent>(text);
-
-			if (mCarousel.type == VERTICAL || mCarousel.type == VERTICAL_WHEEL)
-			{
-				text->setHorizontalAlignment(mCarousel.logoAlignment);
-				text->setVerticalAlignment(ALIGN_CENTER);
-			}
-			else {
-				text->setHorizontalAlignment(ALIGN_CENTER);
-				text->setVerticalAlignment(mCarousel.logoAlignment);
-			}
-		}
+	mLogoSize = carouselLogoSize();
+	updateLoadedEntries();
+}
+
+// number of entries kept loaded on each side of the cursor
+int SystemView::getLoadedEntriesRadius()
+{
+	return mCarousel.maxLogoCount / 2 + logoBuffersRight[2] + CAROUSEL_PREFETCH_COUNT;
+}
+
+// load the logos and extras around the cursor, and release the ones far enough away
+void SystemView::updateLoadedEntries()
+{
+	int count = (int)mEntries.size();
+	if (count == 0)
+		return;
+
+	int radius = getLoadedEntriesRadius();
+
+	for (int i = 0; i < count; i++)
+	{
+		int distance = abs(i - mCursor);
+		distance = Math::min(distance, count - distance);
+
+		if (distance <= radius)
+			loadEntry(i);
+		else if (distance > radius * 2) // hysteresis, so scrolling back and forth does not reload them
+			unloadEntry(i);
+	}
+}
+
+void SystemView::loadEntry(int index)
+{
+	Entry& e = mEntries.at(index);
+	if (e.data.logo)
+		return;
+
+	SystemData* system = e.object;
+	const std::shared_ptr<ThemeData>& theme = system->getTheme();
+
+	e.data.logoIsImage = false;
+
+	// make logo
+	const ThemeData::ThemeElement* logoElem = theme->getElement("system", "logo", "image");
+	if (logoElem && logoElem->has("path"))
+	{
+		std::string path = logoElem->get<std::string>("path");
+		std::string defaultPath = logoElem->has("default") ? logoElem->get<std::string>("default") : "";
 		
+		if ((!path.empty() && ResourceManager::getInstance()->fileExists(path))
+			|| (!defaultPath.empty() && ResourceManager::getInstance()->fileExists(defaultPath)))
+		{								
+			// Remove dynamic flags for png & jpg files : themes can contain oversized images that can't be unloaded by the TextureResource manager
+			ImageComponent* logo = new ImageComponent(mWindow, false, Utils::String::toLower(Utils::FileSystem::getExtension(path)) != ".svg");
+			logo->setMaxSize(carouselLogoSize() * mCarousel.logoScale);						
+			logo->applyTheme(theme, "system", "logo", ThemeFlags::COLOR | ThemeFlags::ALIGNMENT | ThemeFlags::VISIBLE); //  ThemeFlags::PATH | 
+
+			// Process here to be enable to set max picture size
+			if (Utils::FileSystem::exists(path))
+				logo->setImage(path, (logoElem->has("tile") && logoElem->get<bool>("tile")), MaxSizeInfo(carouselLogoSize() * mCarousel.logoScale));
+			
+			logo->setRotateByTargetSize(true);
+			e.data.logo = std::shared_ptr<GuiComponent>(logo);
+			e.data.logoIsImage = true;
+		}
+	}
+
+	if (!e.data.logo)
+	{
+		// no logo in theme; use text
+		TextComponent* text = new TextComponent(mWindow,
+			system->getFullName(),
+			Font::get(FONT_SIZE_LARGE),
+			0x000000FF,
+			ALIGN_CENTER);
+		text->setSize(carouselLogoSize() * mCarousel.logoScale);
+		text->applyTheme(theme, "system", "logoText", ThemeFlags::FONT_PATH | ThemeFlags::FONT_SIZE | ThemeFlags::COLOR | ThemeFlags::FORCE_UPPERCASE | ThemeFlags::LINE_SPACING | ThemeFlags::TEXT);
+		e.data.logo = std::shared_ptr<GuiComponent>(text);
+
 		if (mCarousel.type == VERTICAL || mCarousel.type == VERTICAL_WHEEL)
 		{
-			if (mCarousel.logoAlignment == ALIGN_LEFT)
-				e.data.logo->setOrigin(0, 0.5);
-			else if (mCarousel.logoAlignment == ALIGN_RIGHT)
-				e.data.logo->setOrigin(1.0, 0.5);
-			else
-				e.data.logo->setOrigin(0.5, 0.5);
+			text->setHorizontalAlignment(mCarousel.logoAlignment);
+			text->setVerticalAlignment(ALIGN_CENTER);
 		}
 		else {
-			if (mCarousel.logoAlignment == ALIGN_TOP)
-				e.data.logo->setOrigin(0.5, 0);
-			else if (mCarousel.logoAlignment == ALIGN_BOTTOM)
-				e.data.logo->setOrigin(0.5, 1);
-			else
-				e.data.logo->setOrigin(0.5, 0.5);
+			text->setHorizontalAlignment(ALIGN_CENTER);
+			text->setVerticalAlignment(mCarousel.logoAlignment);
 		}
-
-		
-		Vector2f denormalized = carouselLogoSize() * e.data.logo->getOrigin();
-		e.data.logo->setPosition(denormalized.x(), denormalized.y(), 0.0);
-		// delete any existing extras
-		for (auto extra : e.data.backgroundExtras)
-			delete extra;
-		e.data.backgroundExtras.clear();
-		
-		// make background extras
-		e.data.backgroundExtras = ThemeData::makeExtras((*it)->getTheme(), "system", mWindow);
-		
-		// sort the extras by z-index
-		std::stable_sort(e.data.backgroundExtras.begin(), e.data.backgroundExtras.end(), [](GuiComponent* a, GuiComponent* b) {
-			return b->getZIndex() > a->getZIndex();
-		});
-		
-		this->add(e);
+	}
+	
+	if (mCarousel.type == VERTICAL || mCarousel.type == VERTICAL_WHEEL)
+	{
+		if (mCarousel.logoAlignment == ALIGN_LEFT)
+			e.data.logo->setOrigin(0, 0.5);
+		else if (mCarousel.logoAlignment == ALIGN_RIGHT)
+			e.data.logo->setOrigin(1.0, 0.5);
+		else
+			e.data.logo->setOrigin(0.5, 0.5);
+	}
+	else {
+		if (mCarousel.logoAlignment == ALIGN_TOP)
+			e.data.logo->setOrigin(0.5, 0);
+		else if (mCarousel.logoAlignment == ALIGN_BOTTOM)
+			e.data.logo->setOrigin(0.5, 1);
+		else
+			e.data.logo->setOrigin(0.5, 0.5);
 	}
 
-	if (mEntries.size() == 0)
+	Vector2f denormalized = carouselLogoSize() * e.data.logo->getOrigin();
+	e.data.logo->setPosition(denormalized.x(), denormalized.y(), 0.0);
+	
+	// make background extras
+	e.data.backgroundExtras = ThemeData::makeExtras(theme, "system", mWindow);
+	
+	// sort the extras by z-index
+	std::stable_sort(e.data.backgroundExtras.begin(), e.data.backgroundExtras.end(), [](GuiComponent* a, GuiComponent* b) {
+		return b->getZIndex() > a->getZIndex();
+	});
+
+	// new extras must not start playing until their system is activated
+	bool active = index == mCursor && mShowing && !mScreensaverActive && !mDisable;
+	for (auto extra : e.data.backgroundExtras)
 	{
-		// Something is wrong, there is not a single system to show, check if UI mode is not full
-		if (!UIModeController::getInstance()->isUIModeFull())
-		{
-			Settings::getInstance()->setString("UIMode", "Full");
-			mWindow->pushGui(new GuiMsgBox(mWindow, "The selected UI mode has nothing to show,\n returning to UI mode: FULL", "OK", nullptr));
-		}
+		if (mScreensaverActive)
+			extra->onScreenSaverActivate();
+
+		if (!active)
+			extra->onHide();
 	}
 }
 
+void SystemView::unloadEntry(int index)
+{
+	Entry& e = mEntries.at(index);
+	if (!e.data.logo)
+		return;
+
+	for (auto extra : e.data.backgroundExtras)
+		delete extra;
+
+	e.data.backgroundExtras.clear();
+	e.data.logo.reset();
+	e.data.logoIsImage = false;
+}
+
 void SystemView::goToSystem(SystemData* system, bool animate)
 {
 	setCursor(system);
@@ -273,6 +332,8 @@ void SystemView::onCursorChanged(const CursorState& /*state*/)
 	// update help style
 	updateHelpPrompts();
 
+	updateLoadedEntries();
+
 	float startPos = mCamOffset;
 
 	float posMax = (float)mEntries.size();
@@ -335,7 +396,7 @@ void SystemView::onCursorChanged(const CursorState& /*state*/)
 
 	// wait 600ms to fade in
 	setAnimation(infoFadeIn, goFast ? 0 : systemInfoDelay, [this] {
-		ViewController::get()->getGameListView(mEntries.at(mCursor).object); // fake preload
+		ViewController::get()->prefetchGameListViews(mEntries.at(mCursor).object);
 	}, false, 2);
 
 	// no need to animate transition, we're not going anywhere (probably mEntries.size() == 1)
@@ -430,8 +491,10 @@ void SystemView::render(const Transform4x4f& parentTrans)
 	if (size() == 0)
 		return;  // nothing to render
 
-	if (mSize.x() != Renderer::getScreenWidth() || mSize.x() != Renderer::getScreenHeight())
+	if (mLogoSize != carouselLogoSize())
 	{
+		mLogoSize = carouselLogoSize();
+
 		for (int i = 0; i < mEntries.size(); i++)
 		{
 			if (mEntries[i].data.logo)
@@ -665,6 +728,8 @@ void SystemView::renderCarousel(const Transform4x4f& trans)
 		int opacity = (int)Math::round(0x80 + ((0xFF - 0x80) * (1.0f - fabs(distance))));
 		opacity = Math::max((int) 0x80, opacity);
 
+		loadEntry(index);
+
 		const std::shared_ptr<GuiComponent> &comp = mEntries.at(index).data.logo;
 		if (mCarousel.type == VERTICAL_WHEEL || mCarousel.type == HORIZONTAL_WHEEL) {
 			comp->setRotationDegrees(mCarousel.logoRotation * distance);
@@ -707,6 +772,8 @@ void SystemView::renderExtras(const Transform4x4f& trans, float lower, float upp
 		//Only render selected system when not showing
 		if (mShowing || index == mCursor)
 		{
+			loadEntry(index);
+
 			Transform4x4f extrasTrans = trans;
 
 			if (Settings::getInstance()->getBool("FixedCarousel"))
@@ -729,7 +796,7 @@ void SystemView::renderExtras(const Transform4x4f& trans, float lower, float upp
 
 			Renderer::pushClipRect(Vector2i((int)extrasTrans.translation()[0], (int)extrasTrans.translation()[1]),
 								   Vector2i((int)mSize.x(), (int)mSize.y()));
-			SystemViewData data = mEntries.at(index).data;
+			const SystemViewData& data = mEntries.at(index).data;
 			for (unsigned int j = 0; j < data.backgroundExtras.size(); j++) {
 				GuiComponent *extra = data.backgroundExtras[j];
 				if (extra->getZIndex() >= lower && extra->getZIndex() < upper) {
@@ -931,7 +998,7 @@ void SystemView::updateExtras(const std::function<void(GuiComponent*)>& func)
 {
 	for (int i = 0; i < mEntries.size(); i++)
 	{
-		SystemViewData data = mEntries.at(i).data;
+		const SystemViewData& data = mEntries.at(i).data;
 		for (unsigned int j = 0; j < data.backgroundExtras.size(); j++)
 		{
 			GuiComponent* extra = data.backgroundExtras[j];
@@ -947,7 +1014,7 @@ void SystemView::activateExtras(int cursor, bool activate)
 
 	bool show = activate && mShowing && !mScreensaverActive && !mDisable;
 
-	SystemViewData data = mEntries.at(cursor).data;
+	const SystemViewData& data = mEntries.at(cursor).data;
 	for (unsigned int j = 0; j < data.backgroundExtras.size(); j++)
 	{
 		GuiComponent *extra = data.backgroundExtras[j];
@@ -81,6 +81,11 @@ private:
 	void	 updateExtras(const std::function<void(GuiComponent*)>& func);
 	void	 clearEntries();
 
+	void	 updateLoadedEntries();
+	int		 getLoadedEntriesRadius();
+	void	 loadEntry(int index);
+	void	 unloadEntry(int index);
+
 	virtual void onScreenSaverActivate() override;
 	virtual void onScreenSaverDeactivate() override;
 	virtual void topWindow(bool isTop) override;
@@ -112,6 +117,7 @@ private:
 	bool mScreensaverActive;
 
 	int mLastCursor;
+	Vector2f mLogoSize;
 };
 
 #endif // ES_APP_VIEWS_SYSTEM_VIEW_H
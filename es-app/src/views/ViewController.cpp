@@ -11,8 +11,11 @@
 #include "views/gamelist/VideoGameListView.h"
 #include "views/SystemView.h"
 #include "views/UIModeController.h"
+#include "CollectionSystemManager.h"
 #include "FileFilterIndex.h"
+#include "GameCatalogue.h"
 #include "Log.h"
+#include "MediaIndex.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "Window.h"
@@ -36,10 +39,14 @@ ViewController::ViewController(Window* window)
 	: GuiComponent(window), mCurrentView(nullptr), mCamera(Transform4x4f::Identity()), mFadeOpacity(0), mLockInput(false)
 {
 	mState.viewing = NOTHING;
+	mPrefetchThread = nullptr;
+	mPrefetchRunning = false;
 }
 
 ViewController::~ViewController()
 {
+	stopPrefetch();
+
 	assert(sInstance == this);
 	sInstance = NULL;
 }
@@ -164,6 +171,8 @@ void ViewController::goToGameList(SystemData* system, bool forceImmediate)
 	if (mCurrentView)
 		mCurrentView->onShow();
 
+	prefetchGameListViews(system);
+
 	playViewTransition(forceImmediate);
 }
 
@@ -227,6 +236,16 @@ void ViewController::playViewTransition(bool forceImmediate)
 
 void ViewController::onFileChanged(FileData* file, FileChangeType change)
 {
+	if (change == FILE_METADATA_CHANGED)
+	{
+		GameCatalogue::getInstance()->update(file->getSourceFileData());
+
+		// the media counts used by the screensaver can change with the metadata
+		file->getSystem()->updateDisplayedGameCount();
+		if (file->getSourceFileData()->getSystem() != file->getSystem())
+			file->getSourceFileData()->getSystem()->updateDisplayedGameCount();
+	}
+
 	auto it = mGameListViews.find(file->getSystem());
 	if(it != mGameListViews.cend())
 		it->second->onFileChanged(file, change);
@@ -296,6 +315,9 @@ void ViewController::removeGameListView(SystemData* system)
 		exists->second.reset();
 		mGameListViews.erase(system);
 	}
+
+	mGameListViewsLru.remove(system);
+	mGameListCursors.erase(system);
 }
 
 std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* system, bool loadIfnull)
@@ -303,16 +325,45 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 	//if we already made one, return that one
 	auto exists = mGameListViews.find(system);
 	if(exists != mGameListViews.cend())
+	{
+		touchGameListView(system);
 		return exists->second;
+	}
 
 	if (!loadIfnull)
 		return nullptr;
 
-	system->setUIModeFilters();
-	system->updateDisplayedGameCount();
+	// collections are populated when first shown
+	if (system->isCollection())
+		CollectionSystemManager::get()->populateCollection(system);
 
-	//if we didn't, make it, remember it, and return it
-	std::shared_ptr<IGameListView> view;
+	std::shared_ptr<IGameListView> view = createGameListView(system, getGameListViewInfo(system));
+
+	// back where it was before trimGameListViews released it
+	auto cursor = mGameListCursors.find(system);
+	if (cursor != mGameListCursors.cend())
+	{
+		std::string path = cursor->second;
+		mGameListCursors.erase(cursor);
+
+		system->getRootFolder()->visitFiles(GAME | FOLDER, [&view, &path](FileData* file)
+		{
+			if (file->getPath() != path)
+				return true;
+
+			view->setCursor(file);
+			return false;
+		}, true);
+	}
+
+	trimGameListViews();
+	return view;
+}
+
+// Decides which view type to use, from the settings, the theme & the media of the games
+ViewController::GameListViewInfo ViewController::getGameListViewInfo(SystemData* system)
+{
+	GameListViewInfo info;
 
 	bool themeHasVideoView = system->getTheme()->hasView("video");
 	bool themeHasGridView = system->getTheme()->hasView("grid");
@@ -379,38 +430,82 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 
 		if (system->getTheme()->getDefaultView() != "basic")
 		{
-			std::vector<FileData*> files = system->getRootFolder()->getFilesRecursive(GAME | FOLDER);
-			for (auto it = files.cbegin(); it != files.cend(); it++)
+			// any video makes it a video view, otherwise any thumbnail or image makes it a detailed one
+			bool allowVideo = themeHasVideoView && viewPreference.compare("detailed") != 0;
+			bool localArt = Settings::getInstance()->getBool("LocalArt");
+
+			bool hasVideo = false;
+			bool hasImage = false;
+
+			std::vector<FileData*> withoutMedia;
+
+			system->getRootFolder()->visitFiles(GAME | FOLDER, [&](FileData* file)
 			{
-				if (themeHasVideoView && !(*it)->getVideoPath().empty() && viewPreference.compare("detailed") != 0)
+				if (allowVideo && !file->metadata.get("video").empty())
 				{
-					selectedViewType = VIDEO;
-					break;
+					hasVideo = true;
+					return false;
 				}
-				else if (!(*it)->getThumbnailPath().empty())
+
+				if (!file->metadata.get("thumbnail").empty() || !file->metadata.get("image").empty())
 				{
-					/*
-					if (!allowDetailedDowngrade && (*it)->metadata.get("thumbnail").length() > 0)
+					hasImage = true;
+
+					if (!allowVideo)
+						return false;
+				}
+				else if (localArt)
+					withoutMedia.push_back(file);
+
+				return true;
+			});
+
+			// then the local art of the games without media, the prefetch thread has listed their folders already
+			if (localArt && !hasVideo && (allowVideo || !hasImage))
+			{
+				for (auto file : withoutMedia)
+				{
+					std::string mediaDirectory = file->getSystemEnvData()->mStartPath + "/images";
+
+					if (allowVideo && FileData::hasLocalVideo(mediaDirectory, file->getDisplayName()))
 					{
-						if (themeHasGridView)
-							selectedViewType = GRID;
-						else
-							selectedViewType = DETAILED;
+						hasVideo = true;
+						break;
 					}
-					else*/
-						selectedViewType = DETAILED;
 
-					if (!themeHasVideoView)
-						break;
+					if (!hasImage && FileData::hasLocalImage(mediaDirectory, file->getDisplayName()))
+					{
+						hasImage = true;
 
-					// Don't break out in case any subsequent files have video
+						if (!allowVideo)
+							break;
+					}
 				}
 			}
+
+			if (hasVideo)
+				selectedViewType = VIDEO;
+			else if (hasImage)
+				selectedViewType = DETAILED;
 		}		
 	}
 
+	info.type = selectedViewType;
+	info.customThemeName = customThemeName;
+	info.gridSizeOverride = gridSizeOverride;
+	return info;
+}
+
+// UI side of the view creation : builds the component tree. Must be called from the UI thread.
+std::shared_ptr<IGameListView> ViewController::createGameListView(SystemData* system, const GameListViewInfo& info)
+{
+	system->setUIModeFilters();
+	system->updateDisplayedGameCount();
+
+	std::shared_ptr<IGameListView> view;
+
 	// Create the view
-	switch (selectedViewType)
+	switch (info.type)
 	{
 		case VIDEO:
 			view = std::shared_ptr<IGameListView>(new VideoGameListView(mWindow, system->getRootFolder()));
@@ -420,7 +515,7 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 			break;
 		case GRID:		
 			{
-				view = std::shared_ptr<IGameListView>(new GridGameListView(mWindow, system->getRootFolder(), system->getTheme(), customThemeName, gridSizeOverride));
+				view = std::shared_ptr<IGameListView>(new GridGameListView(mWindow, system->getRootFolder(), system->getTheme(), info.customThemeName, info.gridSizeOverride));
 			}
 						
 			break;
@@ -430,12 +525,12 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 			break;
 	}
 	
-	if (selectedViewType != GRID)
+	if (info.type != GRID)
 	{
 		// GridGameListView theme needs to be loaded before populating.
 
-		if (!customThemeName.empty())
-			view->setThemeName(customThemeName);
+		if (!info.customThemeName.empty())
+			view->setThemeName(info.customThemeName);
 
 		view->setTheme(system->getTheme());
 	}
@@ -447,9 +542,156 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 	addChild(view.get());
 
 	mGameListViews[system] = view;
+	touchGameListView(system);
 	return view;
 }
 
+void ViewController::touchGameListView(SystemData* system)
+{
+	auto it = std::find(mGameListViewsLru.begin(), mGameListViewsLru.end(), system);
+	if (it != mGameListViewsLru.end())
+		mGameListViewsLru.splice(mGameListViewsLru.begin(), mGameListViewsLru, it);
+	else
+		mGameListViewsLru.push_front(system);
+}
+
+// Destroys the least recently used views above the "MaxGameListViews" limit. The current view is always kept.
+void ViewController::trimGameListViews()
+{
+	int maxViews = Settings::getInstance()->getInt("MaxGameListViews");
+	if (maxViews <= 0)
+		return;
+
+	auto it = mGameListViewsLru.end();
+	while ((int)mGameListViews.size() > maxViews && it != mGameListViewsLru.begin())
+	{
+		it--;
+
+		auto view = mGameListViews.find(*it);
+		if (view == mGameListViews.cend())
+		{
+			it = mGameListViewsLru.erase(it);
+			continue;
+		}
+
+		if (view->second == mCurrentView || (mState.viewing == GAME_LIST && mState.system == *it))
+			continue;
+
+		LOG(LogDebug) << "ViewController::trimGameListViews() : releasing " << (*it)->getName();
+
+		// the cursor is restored when the view is built again
+		FileData* cursor = view->second->getCursor();
+		if (cursor != nullptr && !cursor->isPlaceHolder())
+			mGameListCursors[*it] = cursor->getPath();
+
+		mGameListViews.erase(view);
+		it = mGameListViewsLru.erase(it);
+	}
+}
+
+void ViewController::prefetchGameListViews(SystemData* system)
+{
+	// without local art, building a view doesn't read the disk
+	if (!Settings::getInstance()->getBool("LocalArt"))
+		return;
+
+	std::vector<SystemData*> systems;
+	systems.push_back(system);
+
+	// visible neighbours in the system list
+	std::vector<SystemData*>& sysVec = SystemData::sSystemVector;
+	int count = (int)sysVec.size();
+	int id = getSystemId(system);
+	if (id < count)
+	{
+		for (int dir = -1; dir <= 1; dir += 2)
+		{
+			for (int i = 1; i < count; i++)
+			{
+				SystemData* neighbour = sysVec[(id + dir * i + count) % count];
+				if (neighbour->isVisible())
+				{
+					if (std::find(systems.cbegin(), systems.cend(), neighbour) == systems.cend())
+						systems.push_back(neighbour);
+
+					break;
+				}
+			}
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(mPrefetchMutex);
+
+	for (auto sys : systems)
+	{
+		// the games of a collection are in the folders of their own systems
+		if (sys->isCollection() || mGameListViews.find(sys) != mGameListViews.cend())
+			continue;
+
+		std::string mediaDirectory = sys->getSystemEnvData()->mStartPath + "/images";
+		if (std::find(mPrefetchQueue.cbegin(), mPrefetchQueue.cend(), mediaDirectory) == mPrefetchQueue.cend())
+			mPrefetchQueue.push_back(mediaDirectory);
+	}
+
+	if (mPrefetchQueue.size() == 0)
+		return;
+
+	if (mPrefetchThread == nullptr)
+	{
+		mPrefetchRunning = true;
+		mPrefetchThread = new std::thread(&ViewController::prefetchThread, this);
+	}
+
+	mPrefetchEvent.notify_one();
+}
+
+// Only gets folder names : it never reads the systems, their games or the views
+void ViewController::prefetchThread()
+{
+	while (true)
+	{
+		std::string mediaDirectory;
+
+		{
+			std::unique_lock<std::mutex> lock(mPrefetchMutex);
+			mPrefetchEvent.wait(lock, [this] { return !mPrefetchRunning || mPrefetchQueue.size() > 0; });
+
+			if (!mPrefetchRunning)
+				break;
+
+			mediaDirectory = mPrefetchQueue.front();
+			mPrefetchQueue.pop_front();
+		}
+
+		MediaIndex::getInstance()->preloadDirectory(mediaDirectory);
+	}
+}
+
+// Drops pending prefetches
+void ViewController::cancelPrefetch()
+{
+	std::unique_lock<std::mutex> lock(mPrefetchMutex);
+	mPrefetchQueue.clear();
+}
+
+void ViewController::stopPrefetch()
+{
+	cancelPrefetch();
+
+	if (mPrefetchThread == nullptr)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(mPrefetchMutex);
+		mPrefetchRunning = false;
+		mPrefetchEvent.notify_one();
+	}
+
+	mPrefetchThread->join();
+	delete mPrefetchThread;
+	mPrefetchThread = nullptr;
+}
+
 std::shared_ptr<SystemView> ViewController::getSystemListView()
 {
 	//if we already made one, return that one
@@ -596,7 +838,23 @@ void ViewController::preload()
 		}
 
 		(*it)->resetFilters();
-		getGameListView(*it);
+	}
+
+	// only the start system is built now, its neighbours are prefetched and the other views are built on demand
+	SystemData* startSystem = nullptr;
+
+	auto requestedSystem = Settings::getInstance()->getString("StartupSystem");
+	for (auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend() && startSystem == nullptr; it++)
+		if ((*it)->getName() == requestedSystem)
+			startSystem = *it;
+
+	if (startSystem == nullptr && SystemData::sSystemVector.size() > 0)
+		startSystem = SystemData::sSystemVector.at(0);
+
+	if (startSystem != nullptr)
+	{
+		getGameListView(startSystem);
+		prefetchGameListViews(startSystem);
 	}
 
 	// First load the system list
@@ -605,6 +863,8 @@ void ViewController::preload()
 
 void ViewController::reloadGameListView(IGameListView* view, bool reloadTheme)
 {
+	cancelPrefetch();
+
 	if (reloadTheme)
 		ThemeData::setDefaultTheme(nullptr);
 
@@ -652,6 +912,8 @@ void ViewController::reloadGameListView(IGameListView* view, bool reloadTheme)
 
 void ViewController::reloadAll(Window* window)
 {
+	cancelPrefetch();
+
 	ThemeData::setDefaultTheme(nullptr);
 
 	SystemData* system = nullptr;
@@ -672,6 +934,7 @@ void ViewController::reloadAll(Window* window)
 		cursorMap[it->first] = it->second->getCursor();
 
 	mGameListViews.clear();
+	mGameListViewsLru.clear();
 
 	for (auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
 	{
@@ -5,6 +5,11 @@
 #include "renderers/Renderer.h"
 #include "FileData.h"
 #include "GuiComponent.h"
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 class IGameListView;
@@ -21,10 +26,15 @@ public:
 
 	virtual ~ViewController();
 
-	// Try to completely populate the GameListView map.
-	// Caches things so there's no pauses during transitions.
+	// Resets the filters and builds the start system view, the other views are built on demand.
 	void preload();
 
+	// Lists the local media folders of system and its neighbours on the prefetch thread,
+	// so building their views on demand doesn't wait for the disk.
+	void prefetchGameListViews(SystemData* system);
+	// Stops the prefetch thread, before the systems are deleted
+	void stopPrefetch();
+
 	// If a basic view detected a metadata change, it can request to recreate
 	// the current gamelist view (as it may change to be detailed).
 	void reloadGameListView(IGameListView* gamelist, bool reloadTheme = false);
@@ -93,13 +103,35 @@ private:
 	ViewController(Window* window);
 	static ViewController* sInstance;
 
+	struct GameListViewInfo
+	{
+		GameListViewType type;
+		std::string customThemeName;
+		Vector2f gridSizeOverride;
+	};
+
 	void playViewTransition(bool forceImmediate);
 	int getSystemId(SystemData* system);
 
+	GameListViewInfo getGameListViewInfo(SystemData* system);
+	std::shared_ptr<IGameListView> createGameListView(SystemData* system, const GameListViewInfo& info);
+	void touchGameListView(SystemData* system);
+	void trimGameListViews();
+	void cancelPrefetch();
+	void prefetchThread();
+
 	std::shared_ptr<GuiComponent> mCurrentView;
 	std::map< SystemData*, std::shared_ptr<IGameListView> > mGameListViews;
+	std::list<SystemData*> mGameListViewsLru; // most recently used first
+	std::map<SystemData*, std::string> mGameListCursors; // cursor path of the views released by trimGameListViews
 	std::shared_ptr<SystemView> mSystemListView;
 
+	std::thread*							mPrefetchThread;
+	bool									mPrefetchRunning;
+	std::mutex								mPrefetchMutex;
+	std::condition_variable					mPrefetchEvent;
+	std::deque<std::string>					mPrefetchQueue; // media folders to list
+
 	Transform4x4f mCamera;
 	float mFadeOpacity;
 	bool mLockInput;
@@ -60,8 +60,12 @@ void ISimpleGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme
 	}
 }
 
-void ISimpleGameListView::onFileChanged(FileData* /*file*/, FileChangeType /*change*/)
+void ISimpleGameListView::onFileChanged(FileData* /*file*/, FileChangeType change)
 {
+	// the edited game may be displayed, and sorted, in several folders & collections
+	if (change == FILE_METADATA_CHANGED)
+		FolderData::invalidateAllDisplayLists();
+
 	// we could be tricky here to be efficient;
 	// but this shouldn't happen very often so we'll just always repopulate
 	FileData* cursor = getCursor();
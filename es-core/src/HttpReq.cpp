@@ -3,7 +3,9 @@
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include "Settings.h"
 #include <assert.h>
+#include <algorithm>
 
 #include <SDL.h>
 
@@ -13,12 +15,33 @@
 #include <unistd.h>
 #endif
 
+#include <condition_variable>
 #include <mutex>
+#include <thread>
+
+// curl_multi_poll & curl_multi_wakeup are available since libcurl 7.68
+#if LIBCURL_VERSION_NUM >= 0x074400
+#define HAVE_CURL_MULTI_POLL
+#endif
+
 static std::mutex mMutex;
+static std::condition_variable mCompleted;
+static std::condition_variable mWork;
 
-CURLM* HttpReq::s_multi_handle = curl_multi_init();
+static std::thread* mNetworkThread = nullptr;
+static bool mNetworkThreadRunning = false;
+
+CURLM* HttpReq::s_multi_handle = nullptr;
 
 std::map<CURL*, HttpReq*> HttpReq::s_requests;
+std::vector<HttpReq*> HttpReq::s_pendingRequests;
+std::vector<CURL*> HttpReq::s_pendingRemovals;
+
+// Stops the network thread when the program exits
+static struct NetworkThreadGuard
+{
+	~NetworkThreadGuard() { HttpReq::stopNetworkThread(); }
+} mNetworkThreadGuard;
 
 std::string HttpReq::urlEncode(const std::string &s)
 {
@@ -91,8 +114,8 @@ std::string _regGetString(HKEY hKey, const std::string &strPath, const std::stri
 }
 #endif
 
-HttpReq::HttpReq(const std::string& url)
-	: mStatus(REQ_IN_PROGRESS), mHandle(NULL)
+HttpReq::HttpReq(const std::string& url, const std::string& outputFilename, bool validateMedia)
+	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mBytesReceived(0), mValidateMedia(validateMedia), mInvalidMedia(false)
 {
 	mUrl = url;
 
@@ -189,142 +212,310 @@ HttpReq::HttpReq(const std::string& url)
 	}
 #endif
 	
-	std::unique_lock<std::mutex> lock(mMutex);
-
-#if defined(WIN32)
-	srand(time(NULL) % getpid());
-	std::string TempPath;
-	char lpTempPathBuffer[MAX_PATH];
-	if (GetTempPathA(MAX_PATH, lpTempPathBuffer))
+	// Downloads are written next to their destination, so saveContent only has to rename them
+	if (!outputFilename.empty())
 	{
+		mStreamPath = outputFilename + ".part";
+		mStream.open(mStreamPath, std::ios_base::out | std::ios_base::binary);
 
-		TCHAR szTempFileName[MAX_PATH];
-
-		if (GetTempFileName(lpTempPathBuffer, TEXT("httpreq"), 0, szTempFileName))
-			mStreamPath = std::string(szTempFileName);
-		else
+		if (!mStream.is_open())
 		{
-			do { mStreamPath = std::string(lpTempPathBuffer) + "httpreq" + std::to_string(rand() % 99999) + ".tmp"; } 
-			while (Utils::FileSystem::exists(mStreamPath));	
+			mStatus = REQ_IO_ERROR;
+			onError(("Unable to create " + mStreamPath).c_str());
+			return;
 		}
 	}
-	
-#else
-	srand(time(NULL) % getpid() + getppid());
-
-	do { mStreamPath = "/tmp/httpreq" + std::to_string(rand() % 99999) + ".tmp"; }
-	while (Utils::FileSystem::exists(mStreamPath));
-#endif
-	
-	mStream.open(mStreamPath, std::ios_base::out | std::ios_base::binary);
 
-	//add the handle to our multi
-	CURLMcode merr = curl_multi_add_handle(s_multi_handle, mHandle);
-	if(merr != CURLM_OK)
-	{
-		if (mStream.is_open())
-			mStream.close();
+	std::unique_lock<std::mutex> lock(mMutex);
 
-		mStatus = REQ_IO_ERROR;
-		onError(curl_multi_strerror(merr));
-		return;
-	}
+	//the network thread adds the handle to our multi
+	s_pendingRequests.push_back(this);
 
-	s_requests[mHandle] = this;
+	if (mNetworkThread == nullptr)
+		startNetworkThread();
+	else
+		wakeupNetworkThread();
 }
 
 HttpReq::~HttpReq()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 
+	if(mHandle)
+	{
+		auto pending = std::find(s_pendingRequests.begin(), s_pendingRequests.end(), this);
+		if (pending != s_pendingRequests.end())
+			s_pendingRequests.erase(pending);
+		else if (s_requests.find(mHandle) != s_requests.end())
+		{
+			// Only the network thread may touch the multi handle : let it remove the transfer, then wait for it
+			s_pendingRemovals.push_back(mHandle);
+			wakeupNetworkThread();
+
+			mCompleted.wait(lock, [this] { return s_requests.find(mHandle) == s_requests.end(); });
+		}
+
+		curl_easy_cleanup(mHandle);
+	}
+
 	if (mStream.is_open())
 	{
 		mStream.flush();
 		mStream.close();
 	}
 
-	Utils::FileSystem::removeFile(mStreamPath);
+	// Unsaved download
+	if (!mStreamPath.empty() && Utils::String::endsWith(mStreamPath, ".part"))
+		Utils::FileSystem::removeFile(mStreamPath);
+}
 
-	if(mHandle)
-	{
-		s_requests.erase(mHandle);
+HttpReq::Status HttpReq::status()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mStatus;
+}
 
-		CURLMcode merr = curl_multi_remove_handle(s_multi_handle, mHandle);
+HttpReq::Status HttpReq::wait(int timeoutMs)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
 
-		if(merr != CURLM_OK)
-			LOG(LogError) << "Error removing curl_easy handle from curl_multi: " << curl_multi_strerror(merr);
+	if (timeoutMs < 0)
+		mCompleted.wait(lock, [this] { return mStatus != REQ_IN_PROGRESS; });
+	else
+		mCompleted.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return mStatus != REQ_IN_PROGRESS; });
 
-		curl_easy_cleanup(mHandle);
+	return mStatus;
+}
+
+void HttpReq::waitAny(int timeoutMs)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mCompleted.wait_for(lock, std::chrono::milliseconds(timeoutMs));
+}
+
+// mMutex must be locked
+void HttpReq::startNetworkThread()
+{
+	if (s_multi_handle == nullptr)
+	{
+		s_multi_handle = curl_multi_init();
+
+		// Connections are kept in the multi handle cache & reused by the next transfers to the same host
+		curl_multi_setopt(s_multi_handle, CURLMOPT_MAX_HOST_CONNECTIONS, (long)Settings::getInstance()->getInt("HttpMaxConnectionsPerHost"));
+		curl_multi_setopt(s_multi_handle, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)Settings::getInstance()->getInt("HttpMaxConnections"));
+		curl_multi_setopt(s_multi_handle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
 	}
+
+	mNetworkThreadRunning = true;
+	mNetworkThread = new std::thread(&HttpReq::networkThread);
 }
 
-HttpReq::Status HttpReq::status()
+void HttpReq::wakeupNetworkThread()
+{
+#ifdef HAVE_CURL_MULTI_POLL
+	if (s_multi_handle != nullptr)
+		curl_multi_wakeup(s_multi_handle);
+#endif
+	mWork.notify_one();
+}
+
+void HttpReq::stopNetworkThread()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	if (mNetworkThread == nullptr)
+		return;
+
+	mNetworkThreadRunning = false;
+	wakeupNetworkThread();
+
+	lock.unlock();
+	mNetworkThread->join();
+	lock.lock();
+
+	delete mNetworkThread;
+	mNetworkThread = nullptr;
+}
+
+// Owns the multi handle : transfers progress whether or not someone is polling the requests
+void HttpReq::networkThread()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 
-	if(mStatus == REQ_IN_PROGRESS)
+	while (mNetworkThreadRunning)
 	{
+		for (auto req : s_pendingRequests)
+		{
+			CURLMcode merr = curl_multi_add_handle(s_multi_handle, req->mHandle);
+			if (merr != CURLM_OK)
+			{
+				if (req->mStream.is_open())
+					req->mStream.close();
+
+				req->mStatus = REQ_IO_ERROR;
+				req->onError(curl_multi_strerror(merr));
+				mCompleted.notify_all();
+				continue;
+			}
+
+			s_requests[req->mHandle] = req;
+		}
+
+		s_pendingRequests.clear();
+
+		if (s_pendingRemovals.size() > 0)
+		{
+			for (auto handle : s_pendingRemovals)
+			{
+				CURLMcode merr = curl_multi_remove_handle(s_multi_handle, handle);
+				if (merr != CURLM_OK)
+					LOG(LogError) << "Error removing curl_easy handle from curl_multi: " << curl_multi_strerror(merr);
+
+				s_requests.erase(handle);
+			}
+
+			s_pendingRemovals.clear();
+			mCompleted.notify_all();
+		}
+
+		if (s_requests.size() == 0)
+		{
+			mWork.wait(lock, [] { return !mNetworkThreadRunning || s_pendingRequests.size() > 0; });
+			continue;
+		}
+
+		// Write callbacks run here, without mMutex, so status() & getPercent() never wait for the disk.
+		// The requests can't be destroyed meanwhile : ~HttpReq waits for this thread to remove them from s_requests,
+		// which only happens below, under mMutex. The callbacks only touch their own request.
+		lock.unlock();
+
 		int handle_count;
 		CURLMcode merr = curl_multi_perform(s_multi_handle, &handle_count);
-		if(merr != CURLM_OK && merr != CURLM_CALL_MULTI_PERFORM)
+
+		lock.lock();
+
+		if (merr != CURLM_OK && merr != CURLM_CALL_MULTI_PERFORM)
+			LOG(LogError) << "HttpReq network thread error : " << curl_multi_strerror(merr);
+
+		processMessages();
+
+		if (s_requests.size() == 0 || s_pendingRequests.size() > 0 || s_pendingRemovals.size() > 0)
+			continue;
+
+		lock.unlock();
+
+		int numfds;
+#ifdef HAVE_CURL_MULTI_POLL
+		curl_multi_poll(s_multi_handle, NULL, 0, 1000, &numfds);
+#else
+		curl_multi_wait(s_multi_handle, NULL, 0, 50, &numfds);
+#endif
+
+		lock.lock();
+	}
+
+	// Fail everything that was still running
+	for (auto it = s_requests.cbegin(); it != s_requests.cend(); it++)
+	{
+		curl_multi_remove_handle(s_multi_handle, it->first);
+		it->second->mStatus = REQ_IO_ERROR;
+		it->second->onError("Network thread stopped");
+	}
+
+	for (auto req : s_pendingRequests)
+	{
+		req->mStatus = REQ_IO_ERROR;
+		req->onError("Network thread stopped");
+	}
+
+	s_requests.clear();
+	s_pendingRequests.clear();
+	s_pendingRemovals.clear();
+
+	curl_multi_cleanup(s_multi_handle);
+	s_multi_handle = nullptr;
+
+	mCompleted.notify_all();
+}
+
+// mMutex must be locked
+void HttpReq::processMessages()
+{
+	bool completed = false;
+
+	int msgs_left;
+	CURLMsg* msg;
+	while((msg = curl_multi_info_read(s_multi_handle, &msgs_left)) != nullptr)
+	{
+		if(msg->msg != CURLMSG_DONE)
+			continue;
+
+		CURL* handle = msg->easy_handle;
+		CURLcode result = msg->data.result;
+
+		auto it = s_requests.find(handle);
+		if(it == s_requests.end())
 		{
-			if (mStream.is_open())
-				mStream.close();
+			LOG(LogError) << "Cannot find easy handle!";
+			continue;
+		}
 
-			mStatus = REQ_IO_ERROR;
-			onError(curl_multi_strerror(merr));
-			return mStatus;
+		HttpReq* req = it->second;
+
+		if (req->mStream.is_open())
+		{
+			req->mStream.flush();
+			req->mStream.close();
 		}
 
-		int msgs_left;
-		CURLMsg* msg;
-		while((msg = curl_multi_info_read(s_multi_handle, &msgs_left)) != nullptr)
+		if (req->mInvalidMedia)
 		{
-			if(msg->msg == CURLMSG_DONE)
-			{
-				HttpReq* req = s_requests[msg->easy_handle];				
-				if(req == NULL)
-				{
-					LOG(LogError) << "Cannot find easy handle!";
-					continue;
-				}
+			req->mStatus = REQ_INVALID_RESPONSE;
+			req->onError("The server response is invalid");
+		}
+		else if(result == CURLE_OK)
+		{
+			long http_status_code = 0;
+			curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &http_status_code);
 
-				if (req->mStream.is_open())
-				{
-					req->mStream.flush();
-					req->mStream.close();
-				}
-
-				if(msg->data.result == CURLE_OK)
-				{
-					int http_status_code;
-					curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &http_status_code);
-
-					if (http_status_code < 200 || http_status_code > 299)
-					{
-						req->mStatus = REQ_IO_ERROR;
-						std::string err = "HTTP status " + std::to_string(http_status_code);
-						req->onError(err.c_str());
-					}
-					else
-						req->mStatus = REQ_SUCCESS;
-				}
-				else
-				{
-					req->mStatus = REQ_IO_ERROR;
-					req->onError(curl_easy_strerror(msg->data.result));
-				}
+			if (http_status_code < 200 || http_status_code > 299)
+			{
+				req->mStatus = REQ_IO_ERROR;
+				std::string err = "HTTP status " + std::to_string(http_status_code);
+				req->onError(err.c_str());
+			}
+			else if (!req->validateContent())
+			{
+				req->mStatus = REQ_INVALID_RESPONSE;
+				req->onError("The server response is invalid");
 			}
+			else
+				req->mStatus = REQ_SUCCESS;
 		}
+		else
+		{
+			req->mStatus = REQ_IO_ERROR;
+			req->onError(curl_easy_strerror(result));
+		}
+
+		// The transfer is over : release it from the multi handle, its connection stays in the cache for reuse
+		curl_multi_remove_handle(s_multi_handle, handle);
+		s_requests.erase(it);
+
+		completed = true;
 	}
 
-	return mStatus;
+	if (completed)
+		mCompleted.notify_all();
 }
 
 std::string HttpReq::getContent() 
 {
 	assert(mStatus == REQ_SUCCESS);
 
+	if (mStreamPath.empty())
+		return mContent;
+
 	if (mStream.is_open())
 	{
 		mStream.flush();
@@ -352,15 +543,61 @@ std::string HttpReq::getErrorMsg()
 	return mErrorMsg;
 }
 
+// Media servers answer small html pages or error messages instead of 404s
+bool HttpReq::isErrorContent(const std::string& content)
+{
+	auto data = Utils::String::toUpper(content);
+
+	if (data.find("<!DOCTYPE HTML") != std::string::npos)
+		return true;
+
+	if (data.find("NOMEDIA") != std::string::npos || data.find("ERREUR") != std::string::npos || data.find("ERROR") != std::string::npos || data.find("PROBL") != std::string::npos)
+		return true;
+
+	return false;
+}
+
+// Called by the network thread once the transfer is complete
+bool HttpReq::validateContent()
+{
+	if (!mValidateMedia || mBytesReceived >= 1024)
+		return true;
+
+	if (mStreamPath.empty())
+		return !isErrorContent(mContent);
+
+	return !isErrorContent(Utils::FileSystem::readAllText(mStreamPath));
+}
+
 //used as a curl callback
 //size = size of an element, nmemb = number of elements
 //return value is number of elements successfully read
 size_t HttpReq::write_content(void* buff, size_t size, size_t nmemb, void* req_ptr)
 {
 	HttpReq* request = ((HttpReq*)req_ptr);
-		
-	std::ofstream& ss = request->mStream;
-	ss.write((char*)buff, size * nmemb);
+
+	// Check the content type as soon as the first bytes arrive, and abort if it can't be a media
+	if (request->mValidateMedia && request->mBytesReceived == 0)
+	{
+		long http_status_code = 0;
+		char* contentType = nullptr;
+
+		curl_easy_getinfo(request->mHandle, CURLINFO_RESPONSE_CODE, &http_status_code);
+		curl_easy_getinfo(request->mHandle, CURLINFO_CONTENT_TYPE, &contentType);
+
+		if (http_status_code >= 200 && http_status_code <= 299 && contentType != nullptr && Utils::String::startsWith(Utils::String::toLower(contentType), "text/html"))
+		{
+			request->mInvalidMedia = true;
+			return 0;
+		}
+	}
+
+	if (request->mStreamPath.empty())
+		request->mContent.append((char*)buff, size * nmemb);
+	else
+		request->mStream.write((char*)buff, size * nmemb);
+
+	request->mBytesReceived += size * nmemb;
 
 	double cl;
 	if (!curl_easy_getinfo(request->mHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &cl))
@@ -368,10 +605,7 @@ size_t HttpReq::write_content(void* buff, size_t size, size_t nmemb, void* req_p
 		if (cl <= 0)
 			request->mPercent = -1;
 		else
-		{
-			double position = (double)ss.tellp();
-			request->mPercent = (int) (position * 100.0 / cl);
-		}
+			request->mPercent = (int) ((double)request->mBytesReceived * 100.0 / cl);
 	}
 
 	return nmemb;
@@ -387,37 +621,42 @@ int HttpReq::saveContent(const std::string filename, bool checkMedia)
 		mStream.close();
 	}
 
-	if (!Utils::FileSystem::exists(mStreamPath))
-		return false;
+	if (checkMedia && !mValidateMedia && mBytesReceived < 1024 && isErrorContent(getContent()))
+		return 2;
 
-	if (checkMedia && Utils::FileSystem::getFileSize(mStreamPath) < 1024)
+	// Streamed download : move it in place
+	if (!mStreamPath.empty())
 	{
-		auto data = Utils::String::toUpper(getContent());
-		
-		if (data.find("<!DOCTYPE HTML") != std::string::npos)
-			return 2;
-		
-		if (data.find("NOMEDIA") != std::string::npos || data.find("ERREUR") != std::string::npos || data.find("ERROR") != std::string::npos || data.find("PROBL") != std::string::npos)
-			return 2;
+		if (!Utils::FileSystem::exists(mStreamPath))
+			return 1;
+
+		if (mStreamPath == filename)
+			return 0;
+
+		if (Utils::FileSystem::renameFile(mStreamPath, filename))
+		{
+			mStreamPath = filename;
+			return 0;
+		}
+
+		return Utils::FileSystem::copyFile(mStreamPath, filename) ? 0 : 1;
 	}
-	
-	std::ifstream ifs(mStreamPath, std::ios_base::in | std::ios_base::binary);
-	if (ifs.bad())
-		return 1;
 
-	if (Utils::FileSystem::exists(filename))
-		Utils::FileSystem::removeFile(filename);
+	// Memory sink : write a temporary file, then rename it so the destination is never seen half written
+	std::string tmpFile = filename + ".part";
 
-	std::ofstream ofs(filename, std::ios_base::out | std::ios_base::binary);
-	if (ofs.bad())
+	std::ofstream ofs(tmpFile, std::ios_base::out | std::ios_base::binary);
+	if (!ofs.is_open())
 		return 1;
 
-	ofs << ifs.rdbuf();
-
-	ifs.close();
+	ofs.write(mContent.data(), mContent.size());
 	ofs.close();
-	if (ofs.bad())
+
+	if (ofs.bad() || !Utils::FileSystem::renameFile(tmpFile, filename))
+	{
+		Utils::FileSystem::removeFile(tmpFile);
 		return 1;
+	}
 		
 	return 0;
-}
\ No newline at end of file
+}
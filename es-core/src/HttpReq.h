@@ -3,14 +3,20 @@
 #define ES_CORE_HTTP_REQ_H
 
 #include <curl/curl.h>
+#include <atomic>
 #include <map>
 #include <sstream>
 #include <fstream>
+#include <vector>
 
 /* Usage:
- * HttpReq myRequest("www.google.com", "/index.html");
- * //for blocking behavior: while(myRequest.status() == HttpReq::REQ_IN_PROGRESS);
+ * HttpReq myRequest("www.google.com/index.html");
+ * //the response is kept in memory. To stream it straight to a file instead :
+ * //HttpReq myRequest("www.google.com/image.png", "/path/to/image.png", true); then myRequest.saveContent("/path/to/image.png");
+ * //for blocking behavior: myRequest.wait();
  * //for non-blocking behavior: check if(myRequest.status() != HttpReq::REQ_IN_PROGRESS) in some sort of update method
+ *
+ * //transfers are driven by a dedicated network thread, polling status() is not required for them to progress
  * 
  * //once one of those completes, the request is ready
  * if(myRequest.status() != REQ_SUCCESS)
@@ -27,7 +33,9 @@
 class HttpReq
 {
 public:
-	HttpReq(const std::string& url);
+	// outputFilename : stream the response to <outputFilename>.part instead of memory, saveContent(outputFilename) renames it
+	// validateMedia : fail with REQ_INVALID_RESPONSE when the server answers an html page or an error message instead of a media
+	HttpReq(const std::string& url, const std::string& outputFilename = "", bool validateMedia = false);
 
 	~HttpReq();
 
@@ -41,7 +49,12 @@ public:
 		REQ_INVALID_RESPONSE	//the HTTP response was invalid
 	};
 
-	Status status(); //process any received data and return the status afterwards
+	Status status(); //return the current status, never blocks
+
+	Status wait(int timeoutMs = -1); //block until the request completes or the timeout expires (-1 = no timeout)
+	static void waitAny(int timeoutMs); //block until any request completes or the timeout expires
+
+	static void stopNetworkThread(); //abort all transfers and stop the network thread, it restarts with the next request
 
 	std::string getErrorMsg();
 
@@ -67,19 +80,36 @@ private:
 
 	static CURLM* s_multi_handle;
 
+	// Requests waiting to be added to / removed from the multi handle by the network thread
+	static std::vector<HttpReq*> s_pendingRequests;
+	static std::vector<CURL*> s_pendingRemovals;
+
+	static void startNetworkThread();
+	static void wakeupNetworkThread();
+	static void networkThread();
+	static void processMessages();
+
 	void onError(const char* msg);
+	bool validateContent();
+
+	static bool isErrorContent(const std::string& data);
 
 	CURL* mHandle;
 
 	Status mStatus;
 
-	std::string   mStreamPath;
+	std::string   mContent;		// memory sink
+	std::string   mStreamPath;	// file sink
 	std::ofstream mStream;
+	size_t        mBytesReceived;
+
+	bool mValidateMedia;
+	bool mInvalidMedia;
 
 	std::string mErrorMsg;
 	std::string mUrl;
 
-	int mPercent;
+	std::atomic<int> mPercent; // written by the network thread
 };
 
 #endif // ES_CORE_HTTP_REQ_H
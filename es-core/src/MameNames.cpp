@@ -4,7 +4,51 @@
 #include "utils/FileSystemUtil.h"
 #include "Log.h"
 #include <pugixml/src/pugixml.hpp>
+#include <algorithm>
+#include <fstream>
 #include <string.h>
+#include <sys/stat.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Table layout, in uint32 : magic, version, source stamp (2), name count, bios count, device count, strings size,
+// then name offset pairs, bios offsets, device offsets, and the zero terminated strings
+#define MAMENAMES_TABLE_MAGIC   0x4E4D5345 // "ESMN"
+#define MAMENAMES_TABLE_VERSION 1
+#define MAMENAMES_TABLE_HEADER  8
+
+static const char* xmlFiles[] = { ":/mamenames.xml", ":/mamebioses.xml", ":/mamedevices.xml" };
+
+// Changes when any of the xml files is updated
+static uint64_t getSourceStamp()
+{
+	uint64_t stamp = MAMENAMES_TABLE_VERSION;
+
+	for(auto file : xmlFiles)
+	{
+		std::string path = ResourceManager::getInstance()->getResourcePath(file);
+
+		struct stat info;
+		if(stat(path.c_str(), &info) != 0)
+			continue;
+
+		stamp = stamp * 31 + (uint64_t)info.st_size;
+		stamp = stamp * 31 + (uint64_t)info.st_mtime;
+	}
+
+	return stamp;
+
+} // getSourceStamp
+
+static std::string getTablePath()
+{
+	return Utils::FileSystem::getGenericPath(Utils::FileSystem::getHomePath() + "/.emulationstation/mamenames.cache");
+
+} // getTablePath
 
 MameNames* MameNames::sInstance = nullptr;
 
@@ -34,94 +78,235 @@ MameNames* MameNames::getInstance()
 
 } // getInstance
 
-MameNames::MameNames()
+MameNames::MameNames() : mData(nullptr), mDataSize(0), mMapped(false), mNames(nullptr), mBioses(nullptr), mDevices(nullptr),
+	mNameCount(0), mBiosCount(0), mDeviceCount(0), mStrings(nullptr)
 {
-	std::string xmlpath = ResourceManager::getInstance()->getResourcePath(":/mamenames.xml");
-
-	if(!Utils::FileSystem::exists(xmlpath))
+	if(!Utils::FileSystem::exists(ResourceManager::getInstance()->getResourcePath(xmlFiles[0])))
 		return;
 
-	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+	uint64_t    stamp = getSourceStamp();
+	std::string path  = getTablePath();
 
-	pugi::xml_document doc;
-	pugi::xml_parse_result result = doc.load_file(xmlpath.c_str());
+	if(mapTable(path, stamp))
+		return;
 
-	if(!result)
-	{
-		LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
+	std::vector<char> table;
+	if(!buildTable(table, stamp))
 		return;
-	}
 
-	for(pugi::xml_node gameNode = doc.child("game"); gameNode; gameNode = gameNode.next_sibling("game"))
+	// Write the table for the next starts, then map it
+	std::ofstream file(path + ".tmp", std::ios::binary);
+	if(file.is_open())
 	{
-		NamePair namePair = { gameNode.child("mamename").text().get(), gameNode.child("realname").text().get() };
-		mNamePairs.push_back(namePair);
+		file.write(table.data(), table.size());
+		file.close();
+
+		if(!file.fail() && Utils::FileSystem::renameFile(path + ".tmp", path) && mapTable(path, stamp))
+			return;
+
+		Utils::FileSystem::removeFile(path + ".tmp");
 	}
 
-	// Read bios
-	xmlpath = ResourceManager::getInstance()->getResourcePath(":/mamebioses.xml");
+	// Can't write it, keep it in memory
+	mBuffer.swap(table);
+	setTable(mBuffer.data(), mBuffer.size(), stamp);
 
-	if(!Utils::FileSystem::exists(xmlpath))
-		return;
+} // MameNames
+
+MameNames::~MameNames()
+{
+	unmapTable();
+
+} // ~MameNames
 
-	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+bool MameNames::mapTable(const std::string& _path, uint64_t _stamp)
+{
+#if defined(_WIN32)
+	std::ifstream file(_path, std::ios::binary);
+	if(!file.is_open())
+		return false;
+
+	mBuffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
 
-	result = doc.load_file(xmlpath.c_str());
+	if(setTable(mBuffer.data(), mBuffer.size(), _stamp))
+		return true;
+
+	mBuffer.clear();
+	return false;
+#else
+	int fd = open(_path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
 
-	if(!result)
+	struct stat info;
+	if(fstat(fd, &info) != 0 || info.st_size == 0)
 	{
-		LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-		return;
+		close(fd);
+		return false;
 	}
 
-	for(pugi::xml_node biosNode = doc.child("bios"); biosNode; biosNode = biosNode.next_sibling("bios"))
+	void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(data == MAP_FAILED)
+		return false;
+
+	if(!setTable((const char*)data, (size_t)info.st_size, _stamp))
 	{
-		std::string bios = biosNode.text().get();
-		mMameBioses.push_back(bios);
+		munmap(data, (size_t)info.st_size);
+		return false;
 	}
 
-	// Read devices
-	xmlpath = ResourceManager::getInstance()->getResourcePath(":/mamedevices.xml");
+	mMapped = true;
+	return true;
+#endif
 
-	if(!Utils::FileSystem::exists(xmlpath))
-		return;
+} // mapTable
+
+void MameNames::unmapTable()
+{
+#if !defined(_WIN32)
+	if(mMapped)
+		munmap((void*)mData, mDataSize);
+#endif
+
+	mMapped   = false;
+	mData     = nullptr;
+	mDataSize = 0;
+	mBuffer.clear();
+
+} // unmapTable
+
+bool MameNames::setTable(const char* _data, size_t _size, uint64_t _stamp)
+{
+	if(_size < MAMENAMES_TABLE_HEADER * sizeof(uint32_t))
+		return false;
+
+	const uint32_t* header = (const uint32_t*)_data;
+
+	uint64_t stamp;
+	memcpy(&stamp, header + 2, sizeof(stamp));
+
+	if(header[0] != MAMENAMES_TABLE_MAGIC || header[1] != MAMENAMES_TABLE_VERSION || stamp != _stamp)
+		return false;
+
+	const uint32_t nameCount   = header[4];
+	const uint32_t biosCount   = header[5];
+	const uint32_t deviceCount = header[6];
+	const uint32_t stringsSize = header[7];
+	const uint64_t offsets     = MAMENAMES_TABLE_HEADER + (uint64_t)nameCount * 2 + biosCount + deviceCount;
+
+	if(stringsSize == 0 || offsets * sizeof(uint32_t) + stringsSize != _size || _data[_size - 1] != 0)
+		return false;
+
+	// an offset out of the strings would read out of the table
+	for(uint64_t i = MAMENAMES_TABLE_HEADER; i < offsets; i++)
+		if(header[i] >= stringsSize)
+			return false;
 
-	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+	mData        = _data;
+	mDataSize    = _size;
+	mNames       = header + MAMENAMES_TABLE_HEADER;
+	mBioses      = mNames + nameCount * 2;
+	mDevices     = mBioses + biosCount;
+	mNameCount   = nameCount;
+	mBiosCount   = biosCount;
+	mDeviceCount = deviceCount;
+	mStrings     = (const char*)(header + offsets);
 
-	result = doc.load_file(xmlpath.c_str());
+	return true;
 
-	if(!result)
+} // setTable
+
+bool MameNames::buildTable(std::vector<char>& _table, uint64_t _stamp)
+{
+	std::vector<std::pair<std::string, std::string>> names;
+	std::vector<std::string>                         lists[2];
+
+	for(int i = 0; i < 3; i++)
 	{
-		LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-		return;
+		std::string xmlpath = ResourceManager::getInstance()->getResourcePath(xmlFiles[i]);
+
+		if(!Utils::FileSystem::exists(xmlpath))
+			break;
+
+		LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+
+		pugi::xml_document     doc;
+		pugi::xml_parse_result result = doc.load_file(xmlpath.c_str());
+
+		if(!result)
+		{
+			LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
+			break;
+		}
+
+		if(i == 0)
+		{
+			for(pugi::xml_node gameNode = doc.child("game"); gameNode; gameNode = gameNode.next_sibling("game"))
+				names.push_back(std::make_pair(gameNode.child("mamename").text().get(), gameNode.child("realname").text().get()));
+		}
+		else
+		{
+			const char* node = (i == 1 ? "bios" : "device");
+			for(pugi::xml_node child = doc.child(node); child; child = child.next_sibling(node))
+				lists[i - 1].push_back(child.text().get());
+		}
 	}
 
-	for(pugi::xml_node deviceNode = doc.child("device"); deviceNode; deviceNode = deviceNode.next_sibling("device"))
+	if(names.empty())
+		return false;
+
+	// lookups are binary searches with strcmp
+	std::sort(names.begin(), names.end(), [](const std::pair<std::string, std::string>& a, const std::pair<std::string, std::string>& b) { return strcmp(a.first.c_str(), b.first.c_str()) < 0; });
+	for(auto& list : lists)
+		std::sort(list.begin(), list.end(), [](const std::string& a, const std::string& b) { return strcmp(a.c_str(), b.c_str()) < 0; });
+
+	std::vector<uint32_t> offsets;
+	std::string           strings;
+
+	auto addString = [&offsets, &strings](const std::string& value)
 	{
-		std::string device = deviceNode.text().get();
-		mMameDevices.push_back(device);
+		offsets.push_back((uint32_t)strings.size());
+		strings.append(value.c_str(), strlen(value.c_str()) + 1);
+	};
+
+	for(auto& name : names)
+	{
+		addString(name.first);
+		addString(name.second);
 	}
 
-} // MameNames
+	for(auto& list : lists)
+		for(auto& value : list)
+			addString(value);
 
-MameNames::~MameNames()
-{
+	uint32_t header[MAMENAMES_TABLE_HEADER] = { MAMENAMES_TABLE_MAGIC, MAMENAMES_TABLE_VERSION, 0, 0,
+		(uint32_t)names.size(), (uint32_t)lists[0].size(), (uint32_t)lists[1].size(), (uint32_t)strings.size() };
+	memcpy(header + 2, &_stamp, sizeof(_stamp));
 
-} // ~MameNames
+	_table.resize(sizeof(header) + offsets.size() * sizeof(uint32_t) + strings.size());
+	memcpy(_table.data(), header, sizeof(header));
+	memcpy(_table.data() + sizeof(header), offsets.data(), offsets.size() * sizeof(uint32_t));
+	memcpy(_table.data() + sizeof(header) + offsets.size() * sizeof(uint32_t), strings.data(), strings.size());
+
+	return true;
+
+} // buildTable
 
 std::string MameNames::getRealName(const std::string& _mameName)
 {
 	size_t start = 0;
-	size_t end   = mNamePairs.size();
+	size_t end   = mNameCount;
 
 	while(start < end)
 	{
 		const size_t index   = (start + end) / 2;
-		const int    compare = strcmp(mNamePairs[index].mameName.c_str(), _mameName.c_str());
+		const int    compare = strcmp(mStrings + mNames[index * 2], _mameName.c_str());
 
 		if(compare < 0)       start = index + 1;
 		else if( compare > 0) end   = index;
-		else                  return mNamePairs[index].realName;
+		else                  return mStrings + mNames[index * 2 + 1];
 	}
 
 	return _mameName;
@@ -130,25 +315,25 @@ std::string MameNames::getRealName(const std::string& _mameName)
 
 const bool MameNames::isBios(const std::string& _biosName)
 {
-	return MameNames::find(mMameBioses, _biosName);
+	return MameNames::find(mBioses, mBiosCount, _biosName);
 
 } // isBios
 
 const bool MameNames::isDevice(const std::string& _deviceName)
 {
-	return MameNames::find(mMameDevices, _deviceName);
+	return MameNames::find(mDevices, mDeviceCount, _deviceName);
 
 } // isDevice
 
-const bool MameNames::find(std::vector<std::string> devices, const std::string& name)
+const bool MameNames::find(const uint32_t* _table, uint32_t _count, const std::string& _name)
 {
 	size_t start = 0;
-	size_t end   = devices.size();
+	size_t end   = _count;
 
 	while(start < end)
 	{
 		const size_t index   = (start + end) / 2;
-		const int    compare = strcmp(devices[index].c_str(), name.c_str());
+		const int    compare = strcmp(mStrings + _table[index], _name.c_str());
 
 		if(compare < 0)       start = index + 1;
 		else if( compare > 0) end   = index;
@@ -157,4 +342,4 @@ const bool MameNames::find(std::vector<std::string> devices, const std::string&
 
 	return false;
 
-}
+} // find
@@ -2,9 +2,12 @@
 #ifndef ES_CORE_MAMENAMES_H
 #define ES_CORE_MAMENAMES_H
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 
+// The names, bioses & devices lists are converted once from the xml resources into a sorted string table
+// (~/.emulationstation/mamenames.cache), which is then mapped in memory at startup without any parsing.
 class MameNames
 {
 public:
@@ -18,24 +21,30 @@ public:
 
 private:
 
-	struct NamePair
-	{
-		std::string mameName;
-		std::string realName;
-	};
-
-	typedef std::vector<NamePair> namePairVector;
-
 	 MameNames();
 	~MameNames();
 
 	static MameNames* sInstance;
 
-	namePairVector mNamePairs;
-	std::vector<std::string> mMameBioses;
-	std::vector<std::string> mMameDevices;
-
-	const bool find(const std::vector<std::string> devices, const std::string& name);
+	bool mapTable(const std::string& _path, uint64_t _stamp);
+	bool setTable(const char* _data, size_t _size, uint64_t _stamp);
+	bool buildTable(std::vector<char>& _table, uint64_t _stamp);
+	void unmapTable();
+
+	const bool find(const uint32_t* _table, uint32_t _count, const std::string& _name);
+
+	const char*           mData;
+	size_t                mDataSize;
+	bool                  mMapped;
+	std::vector<char>     mBuffer;	// the table, when it can't be mapped
+
+	const uint32_t*       mNames;	// mame name & real name offsets, sorted by mame name
+	const uint32_t*       mBioses;
+	const uint32_t*       mDevices;
+	uint32_t              mNameCount;
+	uint32_t              mBiosCount;
+	uint32_t              mDeviceCount;
+	const char*           mStrings;
 
 }; // MameNames
 
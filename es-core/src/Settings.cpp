@@ -119,6 +119,17 @@ void Settings::setDefaults()
 	mIntMap["ScreenSaverTime"] = 5*60*1000; // 5 minutes
 	mIntMap["ScraperResizeWidth"] = 400;
 	mIntMap["ScraperResizeHeight"] = 0;
+	mIntMap["ScraperThreads"] = 1; // searches running at the same time, ScreenScraper allows 1 thread to anonymous users
+	mIntMap["ScraperMaxDownloads"] = 4;
+	mIntMap["ScraperRequestsPerMinute"] = 120; // 0 = no limit
+	mBoolMap["ScraperCache"] = false; // keeps api responses & original medias, for rescraping with other settings
+	mBoolMap["ScraperCacheReplay"] = false; // serve everything from the scraper cache, never use the network
+	mIntMap["ScraperCacheDays"] = 30; // 0 = never expires
+	mIntMap["ScraperCacheMediaDays"] = 90;
+	mIntMap["ScraperMediaThreads"] = -1; // -1 = one per core but one (2 at most), 0 = resize images on the scraper thread
+	mIntMap["HttpMaxConnectionsPerHost"] = 4;
+	mIntMap["HttpMaxConnections"] = 16;
+	mIntMap["MaxGameListViews"] = 8; // 0 = keep every gamelist view once built
 
 #if defined(_WIN32)
 	mIntMap["MaxVRAM"] = 256;
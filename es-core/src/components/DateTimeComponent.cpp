@@ -1,8 +1,16 @@
 #include "components/DateTimeComponent.h"
 
 #include "utils/StringUtil.h"
+#include "EsLocale.h"
 #include "Log.h"
 #include "Settings.h"
+#include <map>
+
+// Formatted dates only depend on the value, the format & the language : they are shared by all the components
+#define FORMAT_CACHE_MAX	4096
+
+static std::map<std::string, std::string> sFormatCache;
+static std::string sFormatCacheLanguage;
 
 DateTimeComponent::DateTimeComponent(Window* window) : TextComponent(window), mDisplayRelative(false)
 {
@@ -17,13 +25,17 @@ DateTimeComponent::DateTimeComponent(Window* window, const std::string& text, co
 
 void DateTimeComponent::setValue(const std::string& val)
 {
-	mTime = val;
+	// the gamelist views set the same values again while scrolling
+	if (val == mValue)
+		return;
+
+	mValue = val;
 	onTextChanged();
 }
 
 std::string DateTimeComponent::getValue() const
 {
-	return mTime;
+	return Utils::Time::DateTime(mValue);
 }
 
 void DateTimeComponent::setFormat(const std::string& format)
@@ -49,11 +61,12 @@ std::string DateTimeComponent::getDisplayString() const
 {
 	if (mDisplayRelative) {
 		//relative time
-		if(mTime.getTime() == 0)
+		Utils::Time::DateTime time(mValue);
+		if(time.getTime() == 0)
 			return _("never");
 
 		Utils::Time::DateTime now(Utils::Time::now());
-		Utils::Time::Duration dur(now.getTime() - mTime.getTime());
+		Utils::Time::Duration dur(now.getTime() - time.getTime());
 
 		char buf[64];
 
@@ -69,10 +82,23 @@ std::string DateTimeComponent::getDisplayString() const
 		return std::string(buf);
 	}
 
-	if(mTime.getTime() == 0)
-		return _("unknown");
+	if (sFormatCacheLanguage != EsLocale::getLanguage() || sFormatCache.size() >= FORMAT_CACHE_MAX)
+	{
+		sFormatCache.clear();
+		sFormatCacheLanguage = EsLocale::getLanguage();
+	}
+
+	std::string key = mFormat + "\t" + mValue;
+
+	auto it = sFormatCache.find(key);
+	if (it != sFormatCache.cend())
+		return it->second;
+
+	Utils::Time::DateTime time(mValue);
 
-	return Utils::Time::timeToString(mTime.getTime(), mFormat);
+	std::string ret = (time.getTime() == 0 ? _("unknown") : Utils::Time::timeToString(time.getTime(), mFormat));
+	sFormatCache[key] = ret;
+	return ret;
 }
 
 void DateTimeComponent::render(const Transform4x4f& parentTrans)
@@ -31,7 +31,8 @@ protected:
 private:
 	std::string getDisplayString() const;
 
-	Utils::Time::DateTime mTime;
+	// The ISO string, only parsed when the display string isn't cached
+	std::string mValue;
 	std::string mFormat;
 	bool mDisplayRelative;
 };
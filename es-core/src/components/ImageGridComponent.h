@@ -9,9 +9,14 @@
 #include "animations/LambdaAnimation.h"
 #include "Settings.h"
 #include "Sound.h"
+#include <algorithm>
+#include <deque>
 
 #define EXTRAITEMS 2
 
+// Number of textures released by recycled tiles which are kept alive, so scrolling back doesn't reload them
+#define RELEASED_TEXTURES_CACHE 32
+
 enum ScrollDirection
 {
 	SCROLL_VERTICALLY,
@@ -85,6 +90,9 @@ private:
 	void buildTiles();
 	void updateTiles(bool allowAnimation = true, bool updateSelectedState = true);
 	void updateTileAtPos(int tilePos, int imgPos, bool allowAnimation = true, bool updateSelectedState = true);
+	void recycleTiles(int firstImage);
+	void resetTileBindings();
+	void releaseTexture(const std::shared_ptr<TextureResource>& tex);
 	void calcGridDimension();
 	
 	bool isVertical() { return mScrollDirection == SCROLL_VERTICALLY; };
@@ -110,6 +118,21 @@ private:
 	std::shared_ptr<ThemeData> mTheme;
 	std::vector< std::shared_ptr<GridTileComponent> > mTiles;
 
+	// Entry currently bound to each tile, so tiles scrolled into view only rebind what changed
+	struct TileBinding
+	{
+		TileBinding() : bound(false), object() { }
+
+		bool bound;
+		T object;
+	};
+
+	std::vector<TileBinding> mTileBindings;
+	std::vector<Vector3f> mTilePositions;
+	int mTilesFirstImage;
+
+	std::deque<std::shared_ptr<TextureResource>> mReleasedTextures;
+
 	std::string mName;
 
 	int mStartPosition;
@@ -146,6 +169,7 @@ ImageGridComponent<T>::ImageGridComponent(Window* window) : IList<ImageGridData,
 	mAllowVideo = false;
 	mName = "grid";
 	mStartPosition = 0;	
+	mTilesFirstImage = 0;
 	mEntriesDirty = true;
 	mLastCursor = 0;
 	mDefaultGameTexture = ":/cartridge.svg";
@@ -703,46 +727,29 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 			tile->setMarquee("");
 			tile->setVisible(false);
 		}
+
+		resetTileBindings();
 		return;
 	}
 
-	// Temporary store previous texture so they can't be unloaded - avoids flickering & reloading
-	std::vector<std::shared_ptr<TextureResource>> previousTextures;
-	for (int ti = 0; ti < (int)mTiles.size(); ti++)
-	{
-		previousTextures.push_back(mTiles.at(ti)->getTexture(true));
-		previousTextures.push_back(mTiles.at(ti)->getTexture(false));
-	}
+	if (mEntriesDirty)
+		resetTileBindings();
 
-	int i = 0;
-	int end = (int)mTiles.size();
-	int img = mStartPosition;
+	int dimOpposite = isVertical() ? mGridDimension.x() : mGridDimension.y();
+	int img = mStartPosition - EXTRAITEMS * dimOpposite;
 
-	img -= EXTRAITEMS * (isVertical() ? mGridDimension.x() : mGridDimension.y());
+	recycleTiles(img);
 
-	while (i != end)
-	{
-		updateTileAtPos(i, img, allowAnimation, updateSelectedState);
-		i++; img++;
-	}
-	
-	// Collect new textures
-	std::vector<std::shared_ptr<TextureResource>> newTextures;
-	for (int ti = 0; ti < (int)mTiles.size(); ti++)
-	{
-		newTextures.push_back(mTiles.at(ti)->getTexture(true));
-		newTextures.push_back(mTiles.at(ti)->getTexture(false));
-	}
+	// Bind the buffer rows first : the texture loader processes the latest requests first, so visible tiles are loaded before them
+	int bufferTiles = EXTRAITEMS * dimOpposite;
+	int end = (int)mTiles.size();
 
-	// Compare old texture with new textures -> Remove missing from async queue if existing
-	for (auto tex : previousTextures)
-	{
-		if (tex == nullptr)
-			continue;
+	for (int i = 0; i < end; i++)
+		if (i < bufferTiles || i >= end - bufferTiles)
+			updateTileAtPos(i, img + i, allowAnimation, updateSelectedState);
 
-		if (std::find(newTextures.cbegin(), newTextures.cend(), tex) == newTextures.cend())
-			TextureResource::cancelAsync(tex);
-	}
+	for (int i = bufferTiles; i < end - bufferTiles; i++)
+		updateTileAtPos(i, img + i, allowAnimation, updateSelectedState);
 
 	if (updateSelectedState)
 		mLastCursor = mCursor;
@@ -786,6 +793,13 @@ void ImageGridComponent<T>::updateTileAtPos(int tilePos, int imgPos, bool allowA
 		if (updateSelectedState)
 			tile->setSelected(false, allowAnimation);
 
+		if (mTileBindings[tilePos].bound)
+		{
+			releaseTexture(tile->getTexture(false));
+			releaseTexture(tile->getTexture(true));
+			mTileBindings[tilePos].bound = false;
+		}
+
 		tile->resetImages();
 		tile->setVisible(false);
 	}
@@ -793,25 +807,37 @@ void ImageGridComponent<T>::updateTileAtPos(int tilePos, int imgPos, bool allowA
 	{
 		tile->setVisible(true);
 
-		std::string name = mEntries.at(imgPos).name; // .object->getName();
-		tile->setLabel(name);
+		TileBinding& binding = mTileBindings[tilePos];
 
-		std::string imagePath = mEntries.at(imgPos).data.texturePath;
+		// Tile recycled with the entry it already displays : keep label & textures as they are
+		if (!binding.bound || !(binding.object == mEntries.at(imgPos).object))
+		{
+			releaseTexture(tile->getTexture(false));
+			releaseTexture(tile->getTexture(true));
 
-		if (ResourceManager::getInstance()->fileExists(imagePath))
-			tile->setImage(imagePath);
-		else if (mEntries.at(imgPos).object->getType() == 2)		
-			tile->setImage(mDefaultFolderTexture);
-		else
-			tile->setImage(mDefaultGameTexture);		
-		
-		// Marquee
-		std::string marqueePath = mEntries.at(imgPos).data.marqueePath;
+			std::string name = mEntries.at(imgPos).name; // .object->getName();
+			tile->setLabel(name);
 
-		if (!marqueePath.empty() && ResourceManager::getInstance()->fileExists(marqueePath))
-			tile->setMarquee(marqueePath);
-		else
-			tile->setMarquee("");
+			std::string imagePath = mEntries.at(imgPos).data.texturePath;
+
+			if (ResourceManager::getInstance()->fileExists(imagePath))
+				tile->setImage(imagePath);
+			else if (mEntries.at(imgPos).object->getType() == 2)		
+				tile->setImage(mDefaultFolderTexture);
+			else
+				tile->setImage(mDefaultGameTexture);		
+
+			// Marquee
+			std::string marqueePath = mEntries.at(imgPos).data.marqueePath;
+
+			if (!marqueePath.empty() && ResourceManager::getInstance()->fileExists(marqueePath))
+				tile->setMarquee(marqueePath);
+			else
+				tile->setMarquee("");
+
+			binding.bound = true;
+			binding.object = mEntries.at(imgPos).object;
+		}
 
 		// Video
 		if (mAllowVideo && imgPos == mCursor)
@@ -850,6 +876,53 @@ void ImageGridComponent<T>::updateTileAtPos(int tilePos, int imgPos, bool allowA
 	}
 }
 
+// Rotate tiles so the ones still showing an entry after a scroll keep it, and only the rows entering the buffer get rebound
+template<typename T>
+void ImageGridComponent<T>::recycleTiles(int firstImage)
+{
+	int shift = firstImage - mTilesFirstImage;
+	mTilesFirstImage = firstImage;
+
+	int dimOpposite = isVertical() ? mGridDimension.x() : mGridDimension.y();
+	int count = (int)mTiles.size();
+
+	if (shift == 0 || dimOpposite <= 0 || shift % dimOpposite != 0 || std::abs(shift) >= count)
+		return;
+
+	// After rotation, tile i shows the entry which was shown by tile i + shift
+	int middle = shift > 0 ? shift : count + shift;
+	std::rotate(mTiles.begin(), mTiles.begin() + middle, mTiles.end());
+	std::rotate(mTileBindings.begin(), mTileBindings.begin() + middle, mTileBindings.end());
+
+	for (int i = 0; i < count; i++)
+		mTiles[i]->setPosition(mTilePositions[i]);
+}
+
+template<typename T>
+void ImageGridComponent<T>::resetTileBindings()
+{
+	for (auto it = mTileBindings.begin(); it != mTileBindings.end(); it++)
+		it->bound = false;
+}
+
+// Keep the textures of recycled tiles for a while - avoids flickering & reloading when scrolling back
+template<typename T>
+void ImageGridComponent<T>::releaseTexture(const std::shared_ptr<TextureResource>& tex)
+{
+	if (tex == nullptr)
+		return;
+
+	mReleasedTextures.push_back(tex);
+
+	while (mReleasedTextures.size() > RELEASED_TEXTURES_CACHE)
+	{
+		// Remove it from the async queue if nothing else is still waiting for it
+		if (mReleasedTextures.front().use_count() == 1)
+			TextureResource::cancelAsync(mReleasedTextures.front());
+
+		mReleasedTextures.pop_front();
+	}
+}
 
 // Create and position tiles (mTiles)
 template<typename T>
@@ -860,6 +933,8 @@ void ImageGridComponent<T>::buildTiles()
 
 	mStartPosition = 0;
 	mTiles.clear();
+	mTileBindings.clear();
+	mTilePositions.clear();
 
 	calcGridDimension();
 
@@ -909,6 +984,7 @@ void ImageGridComponent<T>::buildTiles()
 
 			tile->setPosition(X * tileDistance.x() + startPosition.x(), Y * tileDistance.y() + startPosition.y());
 			tile->setOrigin(0.5f, 0.5f);			
+			mTilePositions.push_back(tile->getPosition());
 
 			if (mTheme)
 				tile->applyTheme(mTheme, mName, "gridtile", ThemeFlags::ALL);
@@ -920,6 +996,9 @@ void ImageGridComponent<T>::buildTiles()
 		}
 	}
 
+	mTileBindings.resize(mTiles.size());
+	mTilesFirstImage = mStartPosition - EXTRAITEMS * (vert ? mGridDimension.x() : mGridDimension.y());
+
 	mLastCursor = -1;
 	onCursorChanged(CURSOR_STOPPED);
 }
@@ -228,7 +228,7 @@ void Font::getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_ou
 
 	// current textures are full,
 	// make a new one
-	mTextures.push_back(FontTexture());
+	mTextures.emplace_back();
 	tex_out = &mTextures.back();
 	tex_out->initTexture();
 	
@@ -743,6 +743,31 @@ TextCache* Font::buildTextCache(const std::string& text, float offsetX, float of
 	return buildTextCache(text, Vector2f(offsetX, offsetY), color, 0.0f);
 }
 
+std::shared_ptr<TextCache> Font::getTextCache(const std::string& text)
+{
+	auto it = mTextCacheMap.find(text);
+	if (it != mTextCacheMap.cend())
+	{
+		// move to the front of the LRU
+		mTextCacheLru.splice(mTextCacheLru.begin(), mTextCacheLru, it->second.lruPos);
+		return it->second.cache;
+	}
+
+	if (mTextCacheMap.size() >= TEXT_CACHE_MAX_ENTRIES)
+	{
+		// evicted caches stay alive as long as someone still holds them
+		mTextCacheMap.erase(mTextCacheLru.back());
+		mTextCacheLru.pop_back();
+	}
+
+	std::shared_ptr<TextCache> cache = std::shared_ptr<TextCache>(buildTextCache(text, 0, 0, 0x000000FF));
+
+	mTextCacheLru.push_front(text);
+	mTextCacheMap[text] = { cache, mTextCacheLru.begin() };
+
+	return cache;
+}
+
 void TextCache::setColor(unsigned int color)
 {
 	const unsigned int convertedColor = Renderer::convertColor(color);
@@ -9,6 +9,8 @@
 #include "ThemeData.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include <list>
+#include <unordered_map>
 #include <vector>
 
 class TextCache;
@@ -44,6 +46,10 @@ public:
 	Vector2f sizeText(std::string text, float lineSpacing = 1.5f); // Returns the expected size of a string when rendered.  Extra spacing is applied to the Y axis.
 	TextCache* buildTextCache(const std::string& text, float offsetX, float offsetY, unsigned int color);
 	TextCache* buildTextCache(const std::string& text, Vector2f offset, unsigned int color, float xLen, Alignment alignment = ALIGN_LEFT, float lineSpacing = 1.5f);
+
+	// Returns a shared single-line TextCache for text, built at (0, 0). The vertex data is colour-independent : callers set the colour with TextCache::setColor before rendering.
+	// Caches are kept in a size-bounded LRU so lists showing the same strings can reuse them.
+	std::shared_ptr<TextCache> getTextCache(const std::string& text);
 	
 	void renderTextCache(TextCache* cache);
 	void renderGradientTextCache(TextCache* cache, unsigned int colorTop, unsigned int colorBottom, bool horz = false);
@@ -103,7 +109,8 @@ private:
 	void rebuildTextures();
 	void unloadTextures();
 
-	std::vector<FontTexture> mTextures;
+	// a list : the glyphs and the cached TextCaches keep pointers to the textures, a new texture must not move the others
+	std::list<FontTexture> mTextures;
 
 	void getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out);
 
@@ -137,6 +144,16 @@ private:
 
 	float getNewlineStartOffset(const std::string& text, const unsigned int& charStart, const float& xLen, const Alignment& alignment);
 
+	static const size_t TEXT_CACHE_MAX_ENTRIES = 1024;
+
+	struct SharedTextCache
+	{
+		std::shared_ptr<TextCache> cache;
+		std::list<std::string>::iterator lruPos;
+	};
+
+	std::unordered_map<std::string, SharedTextCache> mTextCacheMap;
+	std::list<std::string> mTextCacheLru; // most recently used first
 
 	bool mLoaded;
 
@@ -690,6 +690,30 @@ namespace Utils
 			return true;
 		} // removeFile
 
+		bool linkFile(const std::string src, const std::string dst)
+		{
+			std::string path = getGenericPath(src);
+			std::string pathD = getGenericPath(dst);
+
+#if defined(_WIN32)
+			return CreateHardLinkW(Utils::String::convertToWideString(pathD).c_str(), Utils::String::convertToWideString(path).c_str(), NULL) != 0;
+#else
+			return link(path.c_str(), pathD.c_str()) == 0;
+#endif
+		} // linkFile
+
+		bool renameFile(const std::string src, const std::string dst)
+		{
+			std::string path = getGenericPath(src);
+			std::string pathD = getGenericPath(dst);
+
+#if defined(_WIN32)
+			return MoveFileExW(Utils::String::convertToWideString(path).c_str(), Utils::String::convertToWideString(pathD).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+			return rename(path.c_str(), pathD.c_str()) == 0;
+#endif
+		} // renameFile
+
 		bool createDirectory(const std::string& _path)
 		{
 			std::string path = getGenericPath(_path);
@@ -58,6 +58,8 @@ namespace Utils
 		std::string	readAllText(const std::string fileName);
 		void		writeAllText	   (const std::string fileName, const std::string text);
 		bool		copyFile(const std::string src, const std::string dst);
+		bool		linkFile(const std::string src, const std::string dst); // hard link, fails across volumes or on file systems without links
+		bool		renameFile(const std::string src, const std::string dst); // replaces dst atomically when on the same volume
 	} // FileSystem::
 
 
@@ -0,0 +1,283 @@
+// HttpReq against a loopback HTTP server : run by ctest, returns the number of failed checks
+
+#include "utils/FileSystemUtil.h"
+#include "HttpReq.h"
+#include "Settings.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(cond) \
+	do { if (!(cond)) { failures++; std::cerr << __FILE__ << ":" << __LINE__ << " CHECK failed : " #cond << std::endl; } } while (0)
+
+static long long nowMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Keep-alive HTTP/1.1 server on 127.0.0.1, one thread per connection
+//   /hello       -> 200 "hello"
+//   /missing     -> 404
+//   /slow/<ms>   -> 200 "slow" after <ms> milliseconds
+class LoopbackServer
+{
+public:
+	LoopbackServer() : mPort(0), mRunning(true), mConnections(0), mMaxConnections(0)
+	{
+		mSocket = socket(AF_INET, SOCK_STREAM, 0);
+
+		int yes = 1;
+		setsockopt(mSocket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+
+		socklen_t len = sizeof(addr);
+		if (bind(mSocket, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(mSocket, 64) != 0 || getsockname(mSocket, (sockaddr*)&addr, &len) != 0)
+		{
+			std::cerr << "LoopbackServer : unable to listen" << std::endl;
+			exit(1);
+		}
+
+		mPort = ntohs(addr.sin_port);
+		mThread = std::thread(&LoopbackServer::acceptLoop, this);
+	}
+
+	~LoopbackServer()
+	{
+		mRunning = false;
+		shutdown(mSocket, SHUT_RDWR);
+		close(mSocket);
+		mThread.join();
+
+		// the connections end when curl closes them, in HttpReq::stopNetworkThread
+		while (mConnections > 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	std::string url(const std::string& path) { return "http://127.0.0.1:" + std::to_string(mPort) + path; }
+
+	int getMaxConnections() { return mMaxConnections; }
+	void resetMaxConnections() { mMaxConnections = (int)mConnections; }
+
+private:
+	void acceptLoop()
+	{
+		while (mRunning)
+		{
+			int client = accept(mSocket, nullptr, nullptr);
+			if (client < 0)
+				continue;
+
+			int count = ++mConnections;
+
+			int max = mMaxConnections;
+			while (count > max && !mMaxConnections.compare_exchange_weak(max, count));
+
+			std::thread(&LoopbackServer::serve, this, client).detach();
+		}
+	}
+
+	void serve(int client)
+	{
+		std::string buffer;
+		char data[4096];
+
+		while (true)
+		{
+			auto end = buffer.find("\r\n\r\n");
+			if (end == std::string::npos)
+			{
+				ssize_t size = recv(client, data, sizeof(data), 0);
+				if (size <= 0)
+					break;
+
+				buffer.append(data, size);
+				continue;
+			}
+
+			std::string request = buffer.substr(0, end);
+			buffer = buffer.substr(end + 4);
+
+			auto pathStart = request.find(' ') + 1;
+			std::string path = request.substr(pathStart, request.find(' ', pathStart) - pathStart);
+
+			if (!respond(client, path))
+				break;
+		}
+
+		close(client);
+		mConnections--;
+	}
+
+	bool respond(int client, const std::string& path)
+	{
+		std::string status = "200 OK";
+		std::string body;
+
+		if (path == "/hello")
+			body = "hello";
+		else if (path.find("/slow/") == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(atoi(path.substr(6).c_str())));
+			body = "slow";
+		}
+		else
+		{
+			status = "404 Not Found";
+			body = "not found";
+		}
+
+		std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: text/plain\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+		return send(client, response.c_str(), response.size(), MSG_NOSIGNAL) == (ssize_t)response.size();
+	}
+
+	int mSocket;
+	int mPort;
+	std::thread mThread;
+
+	std::atomic<bool> mRunning;
+	std::atomic<int> mConnections;
+	std::atomic<int> mMaxConnections;
+};
+
+static void testCompletion(LoopbackServer& server)
+{
+	HttpReq req(server.url("/hello"));
+
+	CHECK(req.wait(5000) == HttpReq::REQ_SUCCESS);
+	CHECK(req.getContent() == "hello");
+}
+
+static void testFileSink(LoopbackServer& server, const std::string& tmpDir)
+{
+	std::string path = tmpDir + "/hello.txt";
+
+	HttpReq req(server.url("/hello"), path);
+
+	CHECK(req.wait(5000) == HttpReq::REQ_SUCCESS);
+	CHECK(Utils::FileSystem::exists(path + ".part"));
+	CHECK(!Utils::FileSystem::exists(path));
+
+	CHECK(req.saveContent(path) == 0);
+	CHECK(!Utils::FileSystem::exists(path + ".part"));
+	CHECK(Utils::FileSystem::readAllText(path) == "hello");
+}
+
+static void testBadStatusCode(LoopbackServer& server)
+{
+	HttpReq req(server.url("/missing"));
+
+	HttpReq::Status status = req.wait(5000);
+	CHECK(status != HttpReq::REQ_IN_PROGRESS && status != HttpReq::REQ_SUCCESS);
+	CHECK(req.getErrorMsg() == "HTTP status 404");
+}
+
+static void testMaxHostConnections(LoopbackServer& server)
+{
+	// the limit is read when the network thread creates the multi handle
+	HttpReq::stopNetworkThread();
+	Settings::getInstance()->setInt("HttpMaxConnectionsPerHost", 2);
+	server.resetMaxConnections();
+
+	std::vector<std::unique_ptr<HttpReq>> requests;
+	for (int i = 0; i < 6; i++)
+		requests.push_back(std::unique_ptr<HttpReq>(new HttpReq(server.url("/slow/200"))));
+
+	for (auto& req : requests)
+		CHECK(req->wait(10000) == HttpReq::REQ_SUCCESS);
+
+	CHECK(server.getMaxConnections() <= 2);
+
+	HttpReq::stopNetworkThread();
+	Settings::getInstance()->setInt("HttpMaxConnectionsPerHost", 4);
+}
+
+static void testDestroyInFlight(LoopbackServer& server, const std::string& tmpDir)
+{
+	std::string path = tmpDir + "/slow.txt";
+
+	HttpReq* req = new HttpReq(server.url("/slow/3000"), path);
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	CHECK(req->status() == HttpReq::REQ_IN_PROGRESS);
+
+	// the network thread releases the transfer, the destructor doesn't wait for the server
+	long long start = nowMs();
+	delete req;
+	CHECK(nowMs() - start < 1000);
+	CHECK(!Utils::FileSystem::exists(path + ".part"));
+
+	// other requests still complete
+	HttpReq next(server.url("/hello"));
+	CHECK(next.wait(5000) == HttpReq::REQ_SUCCESS);
+}
+
+static void testWaitAny(LoopbackServer& server)
+{
+	HttpReq req(server.url("/slow/200"));
+
+	long long start = nowMs();
+	while (req.status() == HttpReq::REQ_IN_PROGRESS && nowMs() - start < 5000)
+		HttpReq::waitAny(5000);
+
+	CHECK(req.status() == HttpReq::REQ_SUCCESS);
+	CHECK(nowMs() - start < 2000);
+}
+
+static void testStopNetworkThread(LoopbackServer& server)
+{
+	HttpReq req(server.url("/slow/3000"));
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	HttpReq::stopNetworkThread();
+	CHECK(req.status() == HttpReq::REQ_IO_ERROR);
+	CHECK(req.getErrorMsg() == "Network thread stopped");
+
+	// the thread restarts with the next request
+	HttpReq next(server.url("/hello"));
+	CHECK(next.wait(5000) == HttpReq::REQ_SUCCESS);
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+	// keep the settings of the user out of the tests
+	char tmpTemplate[] = "/tmp/es-core-tests-XXXXXX";
+	std::string tmpDir = mkdtemp(tmpTemplate);
+	setenv("HOME", tmpDir.c_str(), 1);
+
+	{
+		LoopbackServer server;
+
+		testCompletion(server);
+		testFileSink(server, tmpDir);
+		testBadStatusCode(server);
+		testMaxHostConnections(server);
+		testDestroyInFlight(server, tmpDir);
+		testWaitAny(server);
+		testStopNetworkThread(server);
+
+		HttpReq::stopNetworkThread();
+	}
+
+	Utils::FileSystem::removeFile(tmpDir + "/hello.txt");
+	rmdir(tmpDir.c_str());
+
+	std::cout << (failures == 0 ? "All HttpReq tests passed" : "HttpReq tests failed") << std::endl;
+	return failures;
+}